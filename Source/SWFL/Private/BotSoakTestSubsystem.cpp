@@ -0,0 +1,335 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BotSoakTestSubsystem.h"
+#include "Engine/World.h"
+#include "Engine/Engine.h"
+#include "UObject/UObjectIterator.h"
+#include "Components/DecalComponent.h"
+#include "Components/AudioComponent.h"
+#include "Particles/ParticleSystemComponent.h"
+#include "HAL/PlatformMemory.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "MainCharacter.h"
+#include "SWFLHeadlessBots.h"
+
+namespace BotSoakTest
+{
+	template<typename ComponentType>
+	int32 CountLiveComponents()
+	{
+		int32 Count = 0;
+
+		for (TObjectIterator<ComponentType> It; It; ++It)
+		{
+			if (!It->IsPendingKill() && It->IsRegistered() && !It->IsTemplate())
+			{
+				Count++;
+			}
+		}
+
+		return Count;
+	}
+}
+
+bool UBotSoakTestSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	return SWFLHeadlessBots::IsRequested(Outer, TEXT("BotSoakTest"));
+}
+
+void UBotSoakTestSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	FParse::Value(FCommandLine::Get(), TEXT("SoakBots="), NumBots);
+	FParse::Value(FCommandLine::Get(), TEXT("SoakDuration="), SoakDuration);
+
+	CsvPath = FPaths::Combine(FPaths::ProfilingDir(), TEXT("BotSoakTest.csv"));
+
+	RandomStream.Initialize(0x50A);
+}
+
+void UBotSoakTestSubsystem::Deinitialize()
+{
+	Bots.Reset();
+	TrackedValues.Reset();
+
+	Super::Deinitialize();
+}
+
+void UBotSoakTestSubsystem::Tick(float DeltaTime)
+{
+	UWorld* World = GetWorld();
+
+	if (!World->HasBegunPlay())
+	{
+		return;
+	}
+
+	const float Now = World->GetTimeSeconds();
+
+	if (!bStarted)
+	{
+		bStarted = true;
+		StartTime = Now;
+		NextSampleTime = Now + WarmupTime;
+		NextRespawnTime = Now + RespawnInterval;
+
+		for (int32 Index = 0; Index < NumBots; ++Index)
+		{
+			SpawnBot();
+		}
+
+		FFileHelper::SaveStringToFile(TEXT("Time,UsedPhysicalMB,Objects,ParticleComponents,DecalComponents,AudioComponents\n"), *CsvPath);
+
+		UE_LOG(LogTemp, Display, TEXT("BotSoakTest: %d bots for %.0f s"), Bots.Num(), SoakDuration);
+	}
+
+	DriveBots(Now);
+
+	if (Now >= NextRespawnTime)
+	{
+		NextRespawnTime = Now + RespawnInterval;
+		RespawnBots();
+	}
+
+	if (bSamplePending)
+	{
+		bSamplePending = false;
+		TakeSample(Now);
+	}
+	else if (Now >= NextSampleTime)
+	{
+		NextSampleTime = Now + SampleInterval;
+		bSamplePending = true;
+		GEngine->ForceGarbageCollection(true);
+	}
+
+	if (bFailed || (Now - StartTime) >= SoakDuration)
+	{
+		Finish();
+	}
+}
+
+void UBotSoakTestSubsystem::SpawnBot()
+{
+	UWorld* World = GetWorld();
+
+	UClass* Class = SWFLHeadlessBots::ResolveCharacterClass(World, CharacterClass, TEXT("BotSoakTest"));
+
+	if (Class == nullptr)
+	{
+		return;
+	}
+
+	// Bots are scattered around the player start, close enough to keep hitting each other
+	const FVector Offset = FVector(RandomStream.FRandRange(-1.f, 1.f), RandomStream.FRandRange(-1.f, 1.f), 0.f) * 1000.f;
+
+	AMainCharacter* Character = SWFLHeadlessBots::SpawnBot(World, Class, SWFLHeadlessBots::GetSpawnOrigin(World) + Offset, FRotator(0.f, RandomStream.FRandRange(0.f, 360.f), 0.f));
+
+	if (Character == nullptr)
+	{
+		return;
+	}
+
+	FBot& Bot = Bots.AddDefaulted_GetRef();
+	Bot.Character = Character;
+	Bot.WanderDirection = FVector::ZeroVector;
+	Bot.NextActionTime = World->GetTimeSeconds() + RandomStream.FRandRange(0.f, ActionInterval);
+	Bot.NextWanderTime = 0.f;
+}
+
+void UBotSoakTestSubsystem::DriveBots(float Now)
+{
+	for (FBot& Bot : Bots)
+	{
+		AMainCharacter* Character = Bot.Character.Get();
+
+		if (Character == nullptr)
+		{
+			continue;
+		}
+
+		// Wander around in a new direction every few seconds
+		if (Now >= Bot.NextWanderTime)
+		{
+			Bot.NextWanderTime = Now + RandomStream.FRandRange(1.f, 3.f);
+			Bot.WanderDirection = FVector(RandomStream.FRandRange(-1.f, 1.f), RandomStream.FRandRange(-1.f, 1.f), 0.f).GetSafeNormal();
+		}
+
+		Character->AddMovementInput(Bot.WanderDirection, 0.5f);
+
+		if (Now < Bot.NextActionTime)
+		{
+			continue;
+		}
+
+		Bot.NextActionTime = Now + ActionInterval * RandomStream.FRandRange(0.5f, 1.5f);
+
+		// Mostly attacks, the rest spread over the other actions
+		const float Roll = RandomStream.FRand();
+
+		if (Roll < 0.5f)
+		{
+			Character->BufferAction(EBufferedAction::EBA_MELEE);
+		}
+		else if (Roll < 0.65f)
+		{
+			Character->ForcePush();
+		}
+		else if (Roll < 0.8f)
+		{
+			Character->BufferAction(EBufferedAction::EBA_EVADE);
+		}
+		else if (Roll < 0.92f)
+		{
+			Character->DoubleJump();
+		}
+		else
+		{
+			Character->ToggleLightsaber();
+		}
+	}
+}
+
+void UBotSoakTestSubsystem::RespawnBots()
+{
+	const int32 NumRespawns = FMath::Clamp(FMath::RoundToInt(Bots.Num() * RespawnFraction), 0, Bots.Num());
+
+	for (int32 Index = 0; Index < NumRespawns; ++Index)
+	{
+		const int32 BotIndex = RandomStream.RandHelper(Bots.Num());
+
+		SWFLHeadlessBots::DestroyBot(Bots[BotIndex].Character.Get());
+
+		Bots.RemoveAtSwap(BotIndex);
+	}
+
+	while (Bots.Num() < NumBots)
+	{
+		const int32 NumBefore = Bots.Num();
+
+		SpawnBot();
+
+		if (Bots.Num() == NumBefore)
+		{
+			break;
+		}
+	}
+}
+
+void UBotSoakTestSubsystem::DestroyBots()
+{
+	for (FBot& Bot : Bots)
+	{
+		SWFLHeadlessBots::DestroyBot(Bot.Character.Get());
+	}
+
+	Bots.Reset();
+}
+
+void UBotSoakTestSubsystem::TakeSample(float Now)
+{
+	using namespace BotSoakTest;
+
+	const double UsedPhysicalMB = double(FPlatformMemory::GetStats().UsedPhysical) / (1024.0 * 1024.0);
+
+	TMap<UClass*, int32> ObjectCounts;
+	int32 NumObjects = 0;
+
+	for (TObjectIterator<UObject> It; It; ++It)
+	{
+		ObjectCounts.FindOrAdd(It->GetClass())++;
+		NumObjects++;
+	}
+
+	const int32 NumParticleComponents = CountLiveComponents<UParticleSystemComponent>();
+	const int32 NumDecalComponents = CountLiveComponents<UDecalComponent>();
+	const int32 NumAudioComponents = CountLiveComponents<UAudioComponent>();
+
+	TrackValue(TEXT("UsedPhysicalMB"), UsedPhysicalMB, MemorySlackMB);
+	TrackValue(TEXT("ParticleComponents"), NumParticleComponents, ComponentCountSlack);
+	TrackValue(TEXT("DecalComponents"), NumDecalComponents, ComponentCountSlack);
+	TrackValue(TEXT("AudioComponents"), NumAudioComponents, ComponentCountSlack);
+
+	for (const TPair<UClass*, int32>& ObjectCount : ObjectCounts)
+	{
+		TrackValue(ObjectCount.Key->GetPathName(), ObjectCount.Value, ObjectCountSlack);
+	}
+
+	bHasBaseline = true;
+
+	const FString Line = FString::Printf(TEXT("%.0f,%.1f,%d,%d,%d,%d\n"),
+		Now - StartTime, UsedPhysicalMB, NumObjects, NumParticleComponents, NumDecalComponents, NumAudioComponents);
+
+	FFileHelper::SaveStringToFile(Line, *CsvPath, FFileHelper::EEncodingOptions::AutoDetect, &IFileManager::Get(), FILEWRITE_Append);
+
+	UE_LOG(LogTemp, Display, TEXT("BotSoakTest: %.0f s, %.1f MB, %d objects, %d particle, %d decal, %d audio components"),
+		Now - StartTime, UsedPhysicalMB, NumObjects, NumParticleComponents, NumDecalComponents, NumAudioComponents);
+}
+
+void UBotSoakTestSubsystem::TrackValue(const FString& Name, double Value, double Slack)
+{
+	FTrackedValue* Tracked = TrackedValues.Find(Name);
+
+	// First sample after warmup is the baseline, values which show up later start from zero
+	if (Tracked == nullptr)
+	{
+		Tracked = &TrackedValues.Add(Name);
+		Tracked->Baseline = bHasBaseline ? 0.0 : Value;
+		Tracked->Slack = Slack;
+	}
+
+	Tracked->Last = Value;
+
+	if (Value > Tracked->Baseline * MaxGrowthRatio + Tracked->Slack)
+	{
+		Tracked->NumSamplesOverLimit++;
+
+		if (Tracked->NumSamplesOverLimit == NumSamplesToFail)
+		{
+			UE_LOG(LogTemp, Error, TEXT("BotSoakTest: %s grows without bound, %.1f from a baseline of %.1f"), *Name, Value, Tracked->Baseline);
+			bFailed = true;
+		}
+	}
+	else
+	{
+		Tracked->NumSamplesOverLimit = 0;
+	}
+}
+
+void UBotSoakTestSubsystem::Finish()
+{
+	bDone = true;
+
+	DestroyBots();
+
+	UE_LOG(LogTemp, Display, TEXT("BotSoakTest: %s"), bFailed ? TEXT("FAILED") : TEXT("PASSED"));
+
+	if (bExitWhenDone)
+	{
+		FPlatformMisc::RequestExitWithStatus(false, bFailed ? 1 : 0);
+	}
+}
+
+bool UBotSoakTestSubsystem::IsTickable() const
+{
+	return !bDone;
+}
+
+ETickableTickType UBotSoakTestSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+UWorld* UBotSoakTestSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+TStatId UBotSoakTestSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UBotSoakTestSubsystem, STATGROUP_Tickables);
+}
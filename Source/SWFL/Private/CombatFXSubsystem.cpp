@@ -0,0 +1,261 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CombatFXSubsystem.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "Lightsaber.h"
+#include "MainCharacter.h"
+#include "SWFLStats.h"
+
+static_assert(static_cast<uint8>(ECombatFXType::CFX_MAX) <= 4, "Combat FX types are sent in 2 bits");
+
+bool FCombatFXEvent::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	uint8 TypeBits = static_cast<uint8>(Type);
+	Ar.SerializeBits(&TypeBits, 2);
+	Type = static_cast<ECombatFXType>(TypeBits);
+
+	UObject* SourceObject = Source;
+	bOutSuccess = Map->SerializeObject(Ar, AActor::StaticClass(), SourceObject);
+	Source = Cast<AActor>(SourceObject);
+
+	bOutSuccess &= SerializePackedVector<10, 24>(Location, Ar);
+
+	// Only contacts with a surface or another blade are oriented
+	if (Type == ECombatFXType::CFX_IMPACT || Type == ECombatFXType::CFX_CLASH)
+	{
+		bOutSuccess &= SerializeFixedVector<1, 8>(Normal, Ar);
+	}
+	else if (Ar.IsLoading())
+	{
+		Normal = FVector::ZeroVector;
+	}
+
+	return true;
+}
+
+void UCombatFXSubsystem::AddEvent(ECombatFXType Type, AActor* Source, const AActor* Instigator, const FVector& Location, const FVector& Normal)
+{
+	UWorld* World = GetWorld();
+
+	if (World == nullptr || Source == nullptr)
+	{
+		return;
+	}
+
+	const ENetMode NetMode = World->GetNetMode();
+
+	if (NetMode == NM_Client)
+	{
+		// Clients play what their own pawn predicted, the server sends them the rest
+		const APawn* Pawn = Cast<APawn>(Instigator);
+
+		if (Pawn && Pawn->IsLocallyControlled())
+		{
+			FCombatFXEvent Event;
+			Event.Type = Type;
+			Event.Source = Source;
+			Event.Location = Location;
+			Event.Normal = Normal;
+			PlayEvent(Event);
+		}
+
+		return;
+	}
+
+	// Nobody watches a dedicated server
+	if (NetMode != NM_DedicatedServer)
+	{
+		FCombatFXEvent Event;
+		Event.Type = Type;
+		Event.Source = Source;
+		Event.Location = Location;
+		Event.Normal = Normal;
+		PlayEvent(Event);
+	}
+
+	if (NetMode != NM_Standalone)
+	{
+		// Played here every frame, but a drag is only sent now and then
+		if (Type == ECombatFXType::CFX_IMPACT && ShouldCoalesceImpact(Source, World->GetTimeSeconds()))
+		{
+			NumCoalesced++;
+			return;
+		}
+
+		FPendingEvent& Pending = PendingEvents.AddDefaulted_GetRef();
+		Pending.Type = Type;
+		Pending.Source = Source;
+		Pending.Instigator = Instigator;
+		Pending.Location = Location;
+		Pending.Normal = Normal;
+	}
+}
+
+bool UCombatFXSubsystem::ShouldCoalesceImpact(AActor* Source, float Now)
+{
+	FImpactContact* Contact = ImpactContacts.Find(Source);
+
+	// A new contact is sent right away
+	if (Contact == nullptr || (Now - Contact->LastImpactTime) > ImpactResendInterval)
+	{
+		FImpactContact& NewContact = ImpactContacts.Add(Source);
+		NewContact.LastImpactTime = Now;
+		NewContact.LastSentTime = Now;
+		return false;
+	}
+
+	Contact->LastImpactTime = Now;
+
+	if ((Now - Contact->LastSentTime) < ImpactResendInterval)
+	{
+		return true;
+	}
+
+	Contact->LastSentTime = Now;
+	return false;
+}
+
+void UCombatFXSubsystem::PlayEvents(const TArray<FCombatFXEvent>& Events)
+{
+	for (const FCombatFXEvent& Event : Events)
+	{
+		PlayEvent(Event);
+	}
+}
+
+void UCombatFXSubsystem::PlayEvent(const FCombatFXEvent& Event)
+{
+	// Source is null on clients it was not replicated to yet
+	switch (Event.Type)
+	{
+	case ECombatFXType::CFX_HIT:
+		if (AMainCharacter* Victim = Cast<AMainCharacter>(Event.Source))
+		{
+			Victim->PlayHitFX(Event.Location);
+		}
+		break;
+	case ECombatFXType::CFX_PUSH:
+		if (AMainCharacter* Character = Cast<AMainCharacter>(Event.Source))
+		{
+			Character->PlayForcePushFX(Event.Location);
+		}
+		break;
+	case ECombatFXType::CFX_IMPACT:
+		if (ALightsaber* Lightsaber = Cast<ALightsaber>(Event.Source))
+		{
+			Lightsaber->PlayImpactFX(Event.Location, Event.Normal);
+		}
+		break;
+	case ECombatFXType::CFX_CLASH:
+		if (ALightsaber* Lightsaber = Cast<ALightsaber>(Event.Source))
+		{
+			Lightsaber->PlayClashFX(Event.Location, Event.Normal);
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+void UCombatFXSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SWFL_CombatFXBatch);
+
+	UWorld* World = GetWorld();
+	const float MaxDistanceSquared = FMath::Square(MaxEventDistance);
+
+	for (FConstPlayerControllerIterator It = World->GetPlayerControllerIterator(); It; ++It)
+	{
+		APlayerController* PlayerController = It->Get();
+
+		if (PlayerController == nullptr || PlayerController->IsLocalController())
+		{
+			continue;
+		}
+
+		AMainCharacter* Receiver = Cast<AMainCharacter>(PlayerController->GetPawn());
+
+		if (Receiver == nullptr)
+		{
+			continue;
+		}
+
+		FVector ViewLocation;
+		FRotator ViewRotation;
+		PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+		const AActor* ViewTarget = PlayerController->GetViewTarget();
+
+		Batch.Reset();
+
+		for (const FPendingEvent& Pending : PendingEvents)
+		{
+			AActor* Source = Pending.Source.Get();
+
+			// Already played by the client which predicted it
+			if (Source == nullptr || Pending.Instigator.Get() == Receiver)
+			{
+				continue;
+			}
+
+			// Too far to be seen, or from an actor the client does not have
+			if (FVector::DistSquared(Pending.Location, ViewLocation) > MaxDistanceSquared
+				|| !Source->IsNetRelevantFor(PlayerController, ViewTarget, ViewLocation)
+				|| Batch.Num() >= MaxEventsPerBatch)
+			{
+				NumCulled++;
+				continue;
+			}
+
+			FCombatFXEvent& Event = Batch.AddDefaulted_GetRef();
+			Event.Type = Pending.Type;
+			Event.Source = Source;
+			Event.Location = Pending.Location;
+			Event.Normal = Pending.Normal;
+		}
+
+		if (Batch.Num() > 0)
+		{
+			Receiver->ClientPlayCombatFX(Batch);
+
+			NumBatchesSent++;
+			NumEventsSent += Batch.Num();
+			INC_DWORD_STAT(STAT_SWFL_CombatFXBatches);
+			INC_DWORD_STAT_BY(STAT_SWFL_CombatFXEvents, Batch.Num());
+		}
+	}
+
+	PendingEvents.Reset();
+
+	// Forget contacts which ended
+	const float Now = World->GetTimeSeconds();
+
+	for (auto It = ImpactContacts.CreateIterator(); It; ++It)
+	{
+		if (!It.Key().IsValid() || (Now - It.Value().LastImpactTime) > ImpactResendInterval)
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
+
+bool UCombatFXSubsystem::IsTickable() const
+{
+	return PendingEvents.Num() > 0;
+}
+
+ETickableTickType UCombatFXSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+UWorld* UCombatFXSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+TStatId UCombatFXSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UCombatFXSubsystem, STATGROUP_Tickables);
+}
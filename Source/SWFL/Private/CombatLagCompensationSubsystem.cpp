@@ -0,0 +1,198 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CombatLagCompensationSubsystem.h"
+#include "Engine/World.h"
+#include "Components/CapsuleComponent.h"
+#include "MainCharacter.h"
+
+void UCombatLagCompensationSubsystem::RegisterCharacter(AMainCharacter* Character)
+{
+	if (Character == nullptr || FindHistory(Character))
+	{
+		return;
+	}
+
+	FPoseHistory& History = Histories.AddDefaulted_GetRef();
+	History.Character = Character;
+	History.CapsuleRadius = Character->GetCapsuleComponent()->GetScaledCapsuleRadius();
+	History.CapsuleHalfHeight = Character->GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
+}
+
+void UCombatLagCompensationSubsystem::UnregisterCharacter(AMainCharacter* Character)
+{
+	Histories.RemoveAllSwap([Character](const FPoseHistory& History) { return History.Character == Character; });
+}
+
+const UCombatLagCompensationSubsystem::FPoseHistory* UCombatLagCompensationSubsystem::FindHistory(const AMainCharacter* Character) const
+{
+	return Histories.FindByPredicate([Character](const FPoseHistory& History) { return History.Character == Character; });
+}
+
+void UCombatLagCompensationSubsystem::Tick(float DeltaTime)
+{
+	const float Now = GetWorld()->GetTimeSeconds();
+
+	// Faster ticks than the buffer can hold over HistoryDuration skip frames instead of shortening the history
+	if ((Now - LastRecordTime) < HistoryDuration / (MaxPoses - 1))
+	{
+		return;
+	}
+
+	LastRecordTime = Now;
+
+	for (int32 Index = Histories.Num() - 1; Index >= 0; --Index)
+	{
+		if (!Histories[Index].Character.IsValid())
+		{
+			Histories.RemoveAtSwap(Index);
+			continue;
+		}
+
+		RecordPose(Histories[Index], Now);
+	}
+}
+
+void UCombatLagCompensationSubsystem::RecordPose(FPoseHistory& History, float Time)
+{
+	const AMainCharacter* Character = History.Character.Get();
+
+	History.Newest = (History.Newest + 1) % MaxPoses;
+	History.Num = FMath::Min(History.Num + 1, MaxPoses);
+
+	FCombatPose& Pose = History.Poses[History.Newest];
+	Pose.Time = Time;
+	Pose.CapsuleLocation = Character->GetActorLocation();
+
+	// Saber actors or blade components, whichever the character wields
+	for (int32 Side = 0; Side < 2; ++Side)
+	{
+		if (!Character->GetBladeSegment(Side, Pose.BladeBase[Side], Pose.BladeTip[Side]))
+		{
+			Pose.BladeBase[Side] = Pose.CapsuleLocation;
+			Pose.BladeTip[Side] = Pose.CapsuleLocation;
+		}
+	}
+}
+
+bool UCombatLagCompensationSubsystem::Rewind(const FPoseHistory& History, float Time, FCombatPose& OutPose)
+{
+	if (History.Num == 0)
+	{
+		return false;
+	}
+
+	const FCombatPose& NewestPose = History.Poses[History.Newest];
+
+	if (Time >= NewestPose.Time)
+	{
+		OutPose = NewestPose;
+		return true;
+	}
+
+	// Walk back from the newest pose to the two surrounding Time
+	const FCombatPose* Newer = &NewestPose;
+
+	for (int32 Age = 1; Age < History.Num; ++Age)
+	{
+		const FCombatPose& Older = History.Poses[(History.Newest - Age + MaxPoses) % MaxPoses];
+
+		if (Older.Time <= Time)
+		{
+			const float Alpha = Newer->Time > Older.Time ? (Time - Older.Time) / (Newer->Time - Older.Time) : 0.f;
+
+			OutPose.Time = Time;
+			OutPose.CapsuleLocation = FMath::Lerp(Older.CapsuleLocation, Newer->CapsuleLocation, Alpha);
+
+			for (int32 Side = 0; Side < 2; ++Side)
+			{
+				OutPose.BladeBase[Side] = FMath::Lerp(Older.BladeBase[Side], Newer->BladeBase[Side], Alpha);
+				OutPose.BladeTip[Side] = FMath::Lerp(Older.BladeTip[Side], Newer->BladeTip[Side], Alpha);
+			}
+
+			return true;
+		}
+
+		Newer = &Older;
+	}
+
+	return false;
+}
+
+bool UCombatLagCompensationSubsystem::ValidateBladeHit(AMainCharacter* Attacker, int32 Side, AMainCharacter* Victim, const FVector& ClaimedBase, const FVector& ClaimedTip, float ViewTime) const
+{
+	if (Attacker == nullptr || Victim == nullptr || Attacker == Victim || (Side != 0 && Side != 1))
+	{
+		return false;
+	}
+
+	const FPoseHistory* AttackerHistory = FindHistory(Attacker);
+	const FPoseHistory* VictimHistory = FindHistory(Victim);
+
+	if (AttackerHistory == nullptr || VictimHistory == nullptr)
+	{
+		return false;
+	}
+
+	// Claims cannot rewind further than the history, nor see the future
+	const float Now = GetWorld()->GetTimeSeconds();
+	const float RewindTime = FMath::Clamp(ViewTime, Now - HistoryDuration, Now);
+
+	FCombatPose AttackerPose;
+	FCombatPose VictimPose;
+
+	if (!Rewind(*AttackerHistory, RewindTime, AttackerPose) || !Rewind(*VictimHistory, RewindTime, VictimPose))
+	{
+		return false;
+	}
+
+	// Attack animations play on the attacker's client, so the claimed blade is trusted within what the server knows:
+	// held by the attacker, no longer than the ignited blade, and crossing the victim's capsule
+	const float BladeLength = FVector::Dist(AttackerPose.BladeBase[Side], AttackerPose.BladeTip[Side]);
+
+	if (BladeLength <= KINDA_SMALL_NUMBER)
+	{
+		return false;
+	}
+
+	if (FVector::Dist(ClaimedTip, ClaimedBase) > BladeLength + HitTolerance)
+	{
+		return false;
+	}
+
+	if (FVector::Dist(ClaimedBase, AttackerPose.CapsuleLocation) > MaxGripDistance + HitTolerance)
+	{
+		return false;
+	}
+
+	// Distance between the blade and the axis of the victim's capsule
+	const FVector CapsuleOffset(0.f, 0.f, FMath::Max(VictimHistory->CapsuleHalfHeight - VictimHistory->CapsuleRadius, 0.f));
+
+	FVector OnBlade;
+	FVector OnCapsule;
+	FMath::SegmentDistToSegmentSafe(ClaimedBase, ClaimedTip, VictimPose.CapsuleLocation - CapsuleOffset, VictimPose.CapsuleLocation + CapsuleOffset, OnBlade, OnCapsule);
+
+	const float MaxDistance = VictimHistory->CapsuleRadius + Attacker->GetBladeRadius(Side) + HitTolerance;
+
+	return FVector::DistSquared(OnBlade, OnCapsule) <= FMath::Square(MaxDistance);
+}
+
+bool UCombatLagCompensationSubsystem::IsTickable() const
+{
+	return Histories.Num() > 0;
+}
+
+ETickableTickType UCombatLagCompensationSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+UWorld* UCombatLagCompensationSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+TStatId UCombatLagCompensationSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UCombatLagCompensationSubsystem, STATGROUP_Tickables);
+}
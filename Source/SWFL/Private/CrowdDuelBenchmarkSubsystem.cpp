@@ -0,0 +1,355 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CrowdDuelBenchmarkSubsystem.h"
+#include "Engine/World.h"
+#include "Engine/Engine.h"
+#include "Misc/CommandLine.h"
+#include "Misc/App.h"
+#include "RenderCore.h"
+#include "MainCharacter.h"
+#include "LightsaberPoolSubsystem.h"
+#include "SWFLStats.h"
+#include "SWFLHeadlessBots.h"
+
+namespace CrowdDuelBenchmark
+{
+	enum class EScriptAction : uint8
+	{
+		Melee,
+		Evade,
+		DoubleStep,
+		ForcePush
+	};
+
+	// Played in a loop by every fighter once its sabers are ignited
+	static const EScriptAction Script[] =
+	{
+		EScriptAction::Melee,
+		EScriptAction::Melee,
+		EScriptAction::Melee,
+		EScriptAction::Melee,
+		EScriptAction::Evade,
+		EScriptAction::Melee,
+		EScriptAction::Melee,
+		EScriptAction::ForcePush,
+		EScriptAction::DoubleStep
+	};
+}
+
+bool UCrowdDuelBenchmarkSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	return SWFLHeadlessBots::IsRequested(Outer, TEXT("CrowdDuelBenchmark"));
+}
+
+void UCrowdDuelBenchmarkSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	FString Sizes;
+
+	if (FParse::Value(FCommandLine::Get(), TEXT("CrowdSizes="), Sizes, false))
+	{
+		TArray<FString> Parts;
+		Sizes.ParseIntoArray(Parts, TEXT(","));
+
+		CrowdSizes.Reset();
+
+		for (const FString& Part : Parts)
+		{
+			CrowdSizes.Add(FMath::Max(FCString::Atoi(*Part), 0));
+		}
+	}
+
+	FParse::Value(FCommandLine::Get(), TEXT("StageDuration="), StageDuration);
+
+	RandomStream.Initialize(0x5F1);
+}
+
+void UCrowdDuelBenchmarkSubsystem::Deinitialize()
+{
+#if CSV_PROFILER
+	if (State == EBenchmarkState::Capturing)
+	{
+		FCsvProfiler::Get()->EndCapture();
+	}
+#endif
+
+	Duelists.Reset();
+
+	Super::Deinitialize();
+}
+
+void UCrowdDuelBenchmarkSubsystem::Tick(float DeltaTime)
+{
+	UWorld* World = GetWorld();
+
+	if (!World->HasBegunPlay())
+	{
+		return;
+	}
+
+	const float Now = World->GetTimeSeconds();
+
+	switch (State)
+	{
+	case EBenchmarkState::WaitingForBeginPlay:
+		StartStage();
+		break;
+
+	case EBenchmarkState::Warmup:
+		DriveCrowd(Now);
+
+		if ((Now - StageStartTime) >= WarmupTime)
+		{
+#if CSV_PROFILER
+			FCsvProfiler::Get()->BeginCapture(-1, FString(), FString::Printf(TEXT("CrowdDuel_%d.csv"), Results.Last().CrowdSize));
+			CSV_METADATA(TEXT("CrowdSize"), *FString::FromInt(Results.Last().CrowdSize));
+#endif
+			State = EBenchmarkState::Capturing;
+		}
+		break;
+
+	case EBenchmarkState::Capturing:
+	{
+		DriveCrowd(Now);
+
+		// Game thread time of the previous frame, the CSV file has the same per frame
+		const double GameThreadMs = FPlatformTime::ToMilliseconds(GGameThreadTime);
+
+		FStageResult& Result = Results.Last();
+		Result.NumFrames++;
+		Result.TotalFrameMs += FApp::GetDeltaTime() * 1000.0;
+		Result.TotalGameThreadMs += GameThreadMs;
+		Result.MaxGameThreadMs = FMath::Max(Result.MaxGameThreadMs, GameThreadMs);
+
+		CSV_CUSTOM_STAT(SWFL, CrowdSize, Result.CrowdSize, ECsvCustomStatOp::Set);
+
+		if ((Now - StageStartTime) >= (WarmupTime + StageDuration))
+		{
+			EndStage();
+		}
+		break;
+	}
+
+	case EBenchmarkState::Teardown:
+#if CSV_PROFILER
+		// The next crowd waits for the previous capture to be written
+		if (FCsvProfiler::Get()->IsCapturing())
+		{
+			break;
+		}
+#endif
+		StageIndex++;
+
+		if (CrowdSizes.IsValidIndex(StageIndex))
+		{
+			StartStage();
+		}
+		else
+		{
+			Finish();
+		}
+		break;
+
+	default:
+		break;
+	}
+}
+
+void UCrowdDuelBenchmarkSubsystem::StartStage()
+{
+	if (!CrowdSizes.IsValidIndex(StageIndex))
+	{
+		Finish();
+		return;
+	}
+
+	const int32 CrowdSize = CrowdSizes[StageIndex];
+
+	FStageResult& Result = Results.AddDefaulted_GetRef();
+	Result.CrowdSize = CrowdSize;
+
+	const ULightsaberPoolSubsystem* Pool = GetWorld()->GetSubsystem<ULightsaberPoolSubsystem>();
+	const int32 NumSpawnedBefore = Pool ? Pool->GetNumSpawned() : 0;
+	const int32 NumReusedBefore = Pool ? Pool->GetNumReused() : 0;
+
+	SpawnCrowd(CrowdSize);
+
+	// Sabers are acquired when the characters begin play, inside SpawnActor
+	if (Pool)
+	{
+		Result.NumSpawned = Pool->GetNumSpawned() - NumSpawnedBefore;
+		Result.NumReused = Pool->GetNumReused() - NumReusedBefore;
+	}
+
+	// The previous crowd released its sabers, this one has to find them waiting
+	if (StageIndex > 0 && Duelists.Num() > 0 && Result.NumReused == 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("CrowdDuelBenchmark: %d fighters reused no pooled saber, %d were spawned"), CrowdSize, Result.NumSpawned);
+		bFailed = true;
+	}
+
+	StageStartTime = GetWorld()->GetTimeSeconds();
+	State = EBenchmarkState::Warmup;
+
+	UE_LOG(LogTemp, Display, TEXT("CrowdDuelBenchmark: %d fighters, %d spawned, sabers %d spawned %d reused"),
+		CrowdSize, Duelists.Num(), Result.NumSpawned, Result.NumReused);
+}
+
+void UCrowdDuelBenchmarkSubsystem::SpawnCrowd(int32 CrowdSize)
+{
+	UWorld* World = GetWorld();
+
+	UClass* Class = SWFLHeadlessBots::ResolveCharacterClass(World, CharacterClass, TEXT("CrowdDuelBenchmark"));
+
+	if (Class == nullptr)
+	{
+		return;
+	}
+
+	// Duels are laid out on a grid around the first player start
+	const FVector Origin = SWFLHeadlessBots::GetSpawnOrigin(World);
+
+	const int32 NumDuels = FMath::DivideAndRoundUp(CrowdSize, 2);
+	const int32 NumColumns = FMath::Max(FMath::CeilToInt(FMath::Sqrt(static_cast<float>(NumDuels))), 1);
+
+	for (int32 Index = 0; Index < CrowdSize; ++Index)
+	{
+		const int32 Duel = Index / 2;
+		const bool bLeftSide = (Index % 2) == 0;
+
+		// Both sides of a duel face each other
+		const FVector DuelCenter = Origin + FVector((Duel % NumColumns) * DuelSpacing, (Duel / NumColumns) * DuelSpacing, 0.f);
+		const FVector Location = DuelCenter + FVector(bLeftSide ? -DuelistSpacing * 0.5f : DuelistSpacing * 0.5f, 0.f, 0.f);
+		const FRotator Rotation(0.f, bLeftSide ? 0.f : 180.f, 0.f);
+
+		AMainCharacter* Character = SWFLHeadlessBots::SpawnBot(World, Class, Location, Rotation);
+
+		if (Character == nullptr)
+		{
+			continue;
+		}
+
+		FDuelist& Duelist = Duelists.AddDefaulted_GetRef();
+		Duelist.Character = Character;
+		Duelist.NextActionTime = World->GetTimeSeconds() + RandomStream.FRandRange(0.f, ActionInterval);
+		Duelist.Step = 0;
+	}
+}
+
+void UCrowdDuelBenchmarkSubsystem::DriveCrowd(float Now)
+{
+	using namespace CrowdDuelBenchmark;
+
+	for (FDuelist& Duelist : Duelists)
+	{
+		AMainCharacter* Character = Duelist.Character.Get();
+
+		if (Character == nullptr || Now < Duelist.NextActionTime)
+		{
+			continue;
+		}
+
+		if (Duelist.Step == 0)
+		{
+			Character->ToggleLightsaber();
+		}
+		else
+		{
+			switch (Script[(Duelist.Step - 1) % UE_ARRAY_COUNT(Script)])
+			{
+			case EScriptAction::Melee:
+				Character->BufferAction(EBufferedAction::EBA_MELEE);
+				break;
+			case EScriptAction::Evade:
+				Character->BufferAction(EBufferedAction::EBA_EVADE);
+				break;
+			case EScriptAction::DoubleStep:
+				Character->BufferAction(EBufferedAction::EBA_DOUBLESTEP);
+				break;
+			case EScriptAction::ForcePush:
+				Character->ForcePush();
+				break;
+			default:
+				break;
+			}
+		}
+
+		Duelist.Step++;
+		Duelist.NextActionTime = Now + ActionInterval * RandomStream.FRandRange(0.8f, 1.2f);
+	}
+}
+
+void UCrowdDuelBenchmarkSubsystem::EndStage()
+{
+#if CSV_PROFILER
+	FCsvProfiler::Get()->EndCapture();
+#endif
+
+	const FStageResult& Result = Results.Last();
+	const int32 NumFrames = FMath::Max(Result.NumFrames, 1);
+
+	UE_LOG(LogTemp, Display, TEXT("CrowdDuelBenchmark: %d fighters, %d frames, frame %.2f ms, game thread %.2f ms avg %.2f ms max"),
+		Result.CrowdSize, Result.NumFrames, Result.TotalFrameMs / NumFrames, Result.TotalGameThreadMs / NumFrames, Result.MaxGameThreadMs);
+
+	DestroyCrowd();
+
+	State = EBenchmarkState::Teardown;
+}
+
+void UCrowdDuelBenchmarkSubsystem::DestroyCrowd()
+{
+	for (FDuelist& Duelist : Duelists)
+	{
+		SWFLHeadlessBots::DestroyBot(Duelist.Character.Get());
+	}
+
+	Duelists.Reset();
+
+	// Start the next crowd from a clean heap
+	GEngine->ForceGarbageCollection(true);
+}
+
+void UCrowdDuelBenchmarkSubsystem::Finish()
+{
+	State = EBenchmarkState::Done;
+
+	UE_LOG(LogTemp, Display, TEXT("CrowdDuelBenchmark: CrowdSize,Frames,AvgFrameMs,AvgGameThreadMs,MaxGameThreadMs,SabersSpawned,SabersReused"));
+
+	for (const FStageResult& Result : Results)
+	{
+		const int32 NumFrames = FMath::Max(Result.NumFrames, 1);
+
+		UE_LOG(LogTemp, Display, TEXT("CrowdDuelBenchmark: %d,%d,%.3f,%.3f,%.3f,%d,%d"),
+			Result.CrowdSize, Result.NumFrames, Result.TotalFrameMs / NumFrames, Result.TotalGameThreadMs / NumFrames, Result.MaxGameThreadMs,
+			Result.NumSpawned, Result.NumReused);
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("CrowdDuelBenchmark: %s"), bFailed ? TEXT("FAILED") : TEXT("PASSED"));
+
+	if (bExitWhenDone)
+	{
+		FPlatformMisc::RequestExitWithStatus(false, bFailed ? 1 : 0);
+	}
+}
+
+bool UCrowdDuelBenchmarkSubsystem::IsTickable() const
+{
+	return State != EBenchmarkState::Done;
+}
+
+ETickableTickType UCrowdDuelBenchmarkSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+UWorld* UCrowdDuelBenchmarkSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+TStatId UCrowdDuelBenchmarkSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UCrowdDuelBenchmarkSubsystem, STATGROUP_Tickables);
+}
@@ -12,7 +12,17 @@
 #include "Engine/DecalActor.h"
 #include "Components/DecalComponent.h"
 #include "Components/BoxComponent.h"
+#include "Components/SkeletalMeshComponent.h"
 #include "MainCharacter.h"
+#include "LightsaberTraceSubsystem.h"
+#include "LightsaberImpactSubsystem.h"
+#include "LightsaberBurnMarkSubsystem.h"
+#include "LightsaberLightBudgetSubsystem.h"
+#include "LightsaberAudioSubsystem.h"
+#include "LightsaberSimulationSubsystem.h"
+#include "CombatFXSubsystem.h"
+#include "SWFLStats.h"
+#include "Net/UnrealNetwork.h"
 
 // Sets default values
 ALightsaber::ALightsaber()
@@ -20,6 +30,17 @@ ALightsaber::ALightsaber()
  	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
 	PrimaryActorTick.bCanEverTick = true;
 
+	// A sheathed saber has nothing to update, so it sleeps until it is ignited
+	PrimaryActorTick.bStartWithTickEnabled = false;
+
+	// Without a blade simulation, tick in the same group it would, after the wielder's pose is final
+	PrimaryActorTick.TickGroup = TG_PostPhysics;
+
+	// Only the saber state is replicated, the saber follows its wielder's mesh on every machine
+	bReplicates = true;
+	SetReplicatingMovement(false);
+	NetUpdateFrequency = 10.f;
+
 	// Create hilt
 	Hilt = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("Hilt"));
 	RootComponent = Hilt;
@@ -35,9 +56,10 @@ ALightsaber::ALightsaber()
 	BladeCollision = CreateDefaultSubobject<UBoxComponent>(TEXT("LeftWeaponBox"));
 	BladeCollision->SetupAttachment(Blade);
 
-	// Add light on blade
+	// Add light along blade, attached to the hilt so scaling the blade does not move it every frame
 	Light = CreateDefaultSubobject<UPointLightComponent>(TEXT("Light"));
-	Light->SetupAttachment(Blade);
+	Light->SetupAttachment(Hilt);
+	Light->SetRelativeLocation(FVector(0, 0, 10 + engineBladeScale * 0.5f));
 	Light->SetVisibility(false);
 
 	// Add unstable look on blade
@@ -45,24 +67,29 @@ ALightsaber::ALightsaber()
 	Beam->SetupAttachment(Blade);
 	Beam->SetVisibility(false);
 
-	// Add unstable look on blade
+	// Add unstable look on blade (trail reads the blade's Base and Tip sockets, so it stays on the blade)
 	Trail = CreateDefaultSubobject<UParticleSystemComponent>(TEXT("TrailVFX"));
 	Trail->SetupAttachment(Blade);
 	Trail->SetVisibility(false);
 
+	// Sounds are attached to the hilt, they do not need to follow the blade's scale
+
 	// Add audio component to store the ignition sound and set its auto activation on false
 	IgniteSound = CreateDefaultSubobject<UAudioComponent>(TEXT("IgniteSFX"));
-	IgniteSound->SetupAttachment(Blade);
+	IgniteSound->SetupAttachment(Hilt);
+	IgniteSound->SetRelativeLocation(FVector(0, 0, 10));
 	IgniteSound->bAutoActivate = false;
 
 	// Add audio component to store the idle sound and set its auto activation on false
 	IdleSound = CreateDefaultSubobject<UAudioComponent>(TEXT("IdleSFX"));
-	IdleSound->SetupAttachment(Blade);
+	IdleSound->SetupAttachment(Hilt);
+	IdleSound->SetRelativeLocation(FVector(0, 0, 10));
 	IdleSound->bAutoActivate = false;
 
 	// Add audio component to store the extinguishing sound and set its auto activation on false
 	ExtinguishSound = CreateDefaultSubobject<UAudioComponent>(TEXT("ExtinguishSFX"));
-	ExtinguishSound->SetupAttachment(Blade);
+	ExtinguishSound->SetupAttachment(Hilt);
+	ExtinguishSound->SetRelativeLocation(FVector(0, 0, 10));
 	ExtinguishSound->bAutoActivate = false;
 
 	// Set max Z scale for blade
@@ -77,6 +104,33 @@ ALightsaber::ALightsaber()
 	// Bool tracking the state of the blade
 	bIsIgnited = false;
 
+	// Keep the local player's blade traced on the game thread, everybody else goes through the async batch
+	bSyncTraceForLocalPlayer = true;
+
+	// Blade starts hidden and retracted
+	zBladeScale = 0.f;
+	bBladeVisible = false;
+
+	// Light has no shadows until the light budget ranks it, a wave of new sabers must not all cast shadows
+	LightTier = ELightsaberLightTier::ELT_UNSHADOWED;
+	bLightCastsShadows = true;
+
+	// Skip component updates smaller than these
+	BladeScaleTolerance = 0.001f;
+	LightIntensityTolerance = 1.f;
+
+	PushedComponentUpdates = 0;
+	SkippedComponentUpdates = 0;
+
+	bIsPooled = false;
+
+	// Blade hits are swept, one pose every 10 degrees or 20 units of travel
+	bIsBladeCollisionActive = false;
+	BladeSweepRadius = 4.f;
+	MaxSubstepAngle = 10.f;
+	MaxSubstepDistance = 20.f;
+	MaxSubsteps = 8;
+
 	// Set hilt socket name
 	HiltSocket = "IgniteVFX";
 	BaseBladeSocket = "Base";
@@ -89,59 +143,338 @@ void ALightsaber::BeginPlay()
 {
 	Super::BeginPlay();
 
-	// Bind functions to blade overlap
-	BladeCollision->OnComponentBeginOverlap.AddDynamic(this, &ALightsaber::OnBladeOverlap);
-
-	// Set blade collisions
+	// Hits are found by sweeping the blade between frames, the box never collides nor updates overlaps
 	BladeCollision->SetCollisionEnabled(ECollisionEnabled::NoCollision);
-	BladeCollision->SetCollisionObjectType(ECollisionChannel::ECC_WorldDynamic);
-	BladeCollision->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
-	BladeCollision->SetCollisionResponseToChannel(ECollisionChannel::ECC_Pawn, ECollisionResponse::ECR_Overlap);
+	BladeCollision->SetGenerateOverlapEvents(false);
+
+	TraceSubsystem = GetWorld()->GetSubsystem<ULightsaberTraceSubsystem>();
+	ImpactSubsystem = GetWorld()->GetSubsystem<ULightsaberImpactSubsystem>();
+	BurnMarkSubsystem = GetWorld()->GetSubsystem<ULightsaberBurnMarkSubsystem>();
+	CombatFXSubsystem = GetWorld()->GetSubsystem<UCombatFXSubsystem>();
+
+	// Remember the shadow setup of the component for the full tier
+	bLightCastsShadows = Light->CastShadows;
+	Light->SetCastShadows(false);
+	LightBudgetSubsystem = GetWorld()->GetSubsystem<ULightsaberLightBudgetSubsystem>();
+	AudioSubsystem = GetWorld()->GetSubsystem<ULightsaberAudioSubsystem>();
+
+	// The blade simulation updates every awake saber in one pass, the actor itself never ticks then
+	SimulationSubsystem = GetWorld()->GetSubsystem<ULightsaberSimulationSubsystem>();
+
+	// Sabers prewarmed by the pool join the light budget once they are acquired
+	if (LightBudgetSubsystem && !bIsPooled)
+	{
+		LightBudgetSubsystem->RegisterLightsaber(this);
+	}
+
+	// Sheathed sabers cost nothing to replicate until they are ignited
+	if (HasAuthority() && !bIsIgnited)
+	{
+		SetNetDormancy(DORM_DormantAll);
+	}
+}
+
+void ALightsaber::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(ALightsaber, NetState);
+}
+
+void ALightsaber::OnRep_NetState()
+{
+	NetState.Apply(*this, zMaxScale);
 }
 
-void ALightsaber::OnBladeOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
+void ALightsaber::SetBladeScaleTarget(float ScaleTarget)
+{
+	zScaleTarget = ScaleTarget;
+	WakeUp();
+}
+
+void ALightsaber::UpdateNetState(float BladeLength)
+{
+	if (!HasAuthority())
+	{
+		return;
+	}
+
+	const FLightsaberNetState NewState = FLightsaberNetState::Quantize(bIsIgnited, BladeLength, zMaxScale);
+
+	if (NewState == NetState)
+	{
+		return;
+	}
+
+	NetState = NewState;
+	ForceNetUpdate();
+}
+
+void ALightsaber::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (LightBudgetSubsystem)
+	{
+		LightBudgetSubsystem->UnregisterLightsaber(this);
+	}
+
+	if (AudioSubsystem)
+	{
+		AudioSubsystem->StopHum(this);
+	}
+
+	if (SimulationSubsystem)
+	{
+		SimulationSubsystem->SleepLightsaber(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void ALightsaber::AttachToMesh(USkeletalMeshComponent* Mesh, FName SocketName)
+{
+	if (Mesh == nullptr)
+	{
+		return;
+	}
+
+	AttachToComponent(Mesh, FAttachmentTransformRules::SnapToTargetNotIncludingScale, SocketName);
+}
+
+void ALightsaber::DetachFromMesh()
+{
+	DetachFromActor(FDetachmentTransformRules::KeepWorldTransform);
+}
+
+void ALightsaber::ReturnToPool()
+{
+	bIsPooled = true;
+
+	DeactivateBladeCollision();
+	DetachFromMesh();
+	SetOwner(nullptr);
+	SetActorHiddenInGame(true);
+
+	// Sheathe without the extinguish sound and effect
+	bIsIgnited = false;
+	zScaleTarget = 0.f;
+	zInterpSpeed = 8.f;
+	bLastBladeTraceHit = false;
+
+	if (Trail)
+	{
+		Trail->EndTrails();
+		Trail->SetVisibility(false);
+	}
+
+	if (AudioSubsystem)
+	{
+		AudioSubsystem->StopHum(this);
+	}
+	else if (IdleSound)
+	{
+		IdleSound->Stop();
+	}
+
+	if (SimulationSubsystem)
+	{
+		SimulationSubsystem->SleepLightsaber(this);
+	}
+
+	SetActorTickEnabled(false);
+
+	UpdateBladeScale(0.f);
+	UpdateLightIntensity(0.f);
+	UpdateBladeVisibility(false);
+
+	if (LightBudgetSubsystem)
+	{
+		LightBudgetSubsystem->UnregisterLightsaber(this);
+	}
+
+	// Acquired again without shadows, until the light budget ranks it
+	SetLightTier(ELightsaberLightTier::ELT_UNSHADOWED);
+
+	if (HasAuthority())
+	{
+		UpdateNetState(0.f);
+		SetNetDormancy(DORM_DormantAll);
+	}
+}
+
+void ALightsaber::LeavePool(AActor* NewOwner)
+{
+	bIsPooled = false;
+
+	SetOwner(NewOwner);
+	SetActorHiddenInGame(false);
+
+	if (LightBudgetSubsystem)
+	{
+		LightBudgetSubsystem->RegisterLightsaber(this);
+	}
+
+	// Send the new owner and visibility, the saber stays dormant until it is ignited
+	if (HasAuthority())
+	{
+		FlushNetDormancy();
+	}
+}
+
+void ALightsaber::OnBladeHit(AActor* OtherActor)
 {
 	auto MainCharacter = Cast<AMainCharacter>(OtherActor);
-	
-	if (GetOwner() && (MainCharacter != GetOwner()))
+	auto Wielder = Cast<AMainCharacter>(GetOwner());
+
+	// Every actor is hit once per activation, like a begin overlap
+	if (MainCharacter == nullptr || Wielder == nullptr || MainCharacter == Wielder || SweptActors.Contains(MainCharacter))
 	{
-		DoDamage(MainCharacter);
+		return;
 	}
+
+	SweptActors.Add(MainCharacter);
+
+	Wielder->HandleBladeHit(Wielder->GetBladeSide(this), MainCharacter);
 }
 
 void ALightsaber::ActivateBladeCollision()
 {
-	BladeCollision->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
+	bIsBladeCollisionActive = true;
+
+	// Sweeping starts from the current pose
+	PrevSweepBase = Blade->GetSocketLocation(BaseBladeSocket);
+	PrevSweepTip = Blade->GetSocketLocation(TipBladeSocket);
+	SweptActors.Reset();
+
+	// Sweeps run with the blade update
+	WakeUp();
 }
 
 void ALightsaber::DeactivateBladeCollision()
 {
-	BladeCollision->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	bIsBladeCollisionActive = false;
+	SweptActors.Reset();
 }
 
-void ALightsaber::DoDamage(class AMainCharacter* Victim)
+void ALightsaber::SetBladeCollisionActive(bool bActive)
 {
-	if (Victim == nullptr)
+	if (bActive)
 	{
-		return;
+		ActivateBladeCollision();
+	}
+	else
+	{
+		DeactivateBladeCollision();
+	}
+}
+
+void ALightsaber::GetBladeSegment(FVector& OutBase, FVector& OutTip) const
+{
+	OutBase = Blade->GetSocketLocation(BaseBladeSocket);
+	OutTip = Blade->GetSocketLocation(TipBladeSocket);
+}
+
+void ALightsaber::SweepBlade()
+{
+	SCOPE_CYCLE_COUNTER(STAT_SWFL_SweepBlade);
+
+	const FVector BasePoint = Blade->GetSocketLocation(BaseBladeSocket);
+	const FVector TipPoint = Blade->GetSocketLocation(TipBladeSocket);
+
+	FCollisionQueryParams CollisionParams(SCENE_QUERY_STAT(LightsaberSweep), false, this);
+	CollisionParams.AddIgnoredActor(GetOwner());
+
+	TArray<AActor*> HitActors;
+	SweepBladeArc(GetWorld(), PrevSweepBase, PrevSweepTip, BasePoint, TipPoint, BladeSweepRadius, MaxSubstepAngle, MaxSubstepDistance, MaxSubsteps, CollisionParams, HitActors);
+
+	for (AActor* HitActor : HitActors)
+	{
+		OnBladeHit(HitActor);
 	}
 
-	auto Character = Cast<AMainCharacter>(Victim);
+	PrevSweepBase = BasePoint;
+	PrevSweepTip = TipPoint;
+}
+
+void ALightsaber::SweepBladeArc(const UWorld* World, const FVector& PrevBase, const FVector& PrevTip, const FVector& Base, const FVector& Tip, float Radius,
+	float MaxSubstepAngle, float MaxSubstepDistance, int32 MaxSubsteps, const FCollisionQueryParams& CollisionParams, TArray<AActor*>& OutHitActors)
+{
+	const FVector PrevBlade = PrevTip - PrevBase;
+	const FVector CurrentBlade = Tip - Base;
+
+	const FVector Direction = CurrentBlade.GetSafeNormal();
+	FVector PrevDirection = PrevBlade.GetSafeNormal();
 
-	if (Character)
+	// A blade which had no length last frame only grows, it does not turn
+	if (PrevDirection.IsZero())
 	{
-		if (Character->GetHitSound())
-		{
-			UGameplayStatics::PlaySoundAtLocation(this, Character->GetHitSound(), Character->GetActorLocation());
-		}
+		PrevDirection = Direction;
+	}
+
+	// Turn and travel of the blade since last frame decide how many poses are swept
+	const float SweptAngle = FMath::RadiansToDegrees(FMath::Acos(FMath::Clamp(FVector::DotProduct(PrevDirection, Direction), -1.f, 1.f)));
+	const float SweptDistance = FMath::Max(FVector::Dist(PrevBase, Base), FVector::Dist(PrevTip, Tip));
+
+	const int32 NumSubsteps = FMath::Clamp(
+		FMath::Max(FMath::CeilToInt(SweptAngle / MaxSubstepAngle), FMath::CeilToInt(SweptDistance / MaxSubstepDistance)),
+		1,
+		MaxSubsteps
+	);
+
+	const FQuat Turn = FQuat::FindBetweenNormals(PrevDirection, Direction);
+	const float PrevLength = PrevBlade.Size();
+	const float CurrentLength = CurrentBlade.Size();
+
+	const FCollisionObjectQueryParams ObjectParams(ECC_Pawn);
+	const FCollisionShape BladeShape = FCollisionShape::MakeSphere(Radius);
+
+	TArray<FHitResult> OutHits;
 
-		if (Character->GetHitVFX())
+	for (int32 Substep = 1; Substep <= NumSubsteps; ++Substep)
+	{
+		const float Alpha = static_cast<float>(Substep) / NumSubsteps;
+
+		// Rotate the blade around its base instead of lerping the tip, so fast arcs do not cut corners
+		const FVector SubstepBase = FMath::Lerp(PrevBase, Base, Alpha);
+		const FVector SubstepDirection = FQuat::Slerp(FQuat::Identity, Turn, Alpha).RotateVector(PrevDirection);
+		const FVector SubstepTip = SubstepBase + SubstepDirection * FMath::Lerp(PrevLength, CurrentLength, Alpha);
+
+		SWFL_COUNT_BLADE_TRACES(1);
+
+		if (World->SweepMultiByObjectType(OutHits, SubstepBase, SubstepTip, FQuat::Identity, ObjectParams, BladeShape, CollisionParams))
 		{
-			UGameplayStatics::SpawnEmitterAtLocation(this, Character->GetHitVFX(), Character->GetActorLocation());
+			for (const FHitResult& Hit : OutHits)
+			{
+				if (AActor* HitActor = Hit.GetActor())
+				{
+					OutHitActors.Add(HitActor);
+				}
+			}
 		}
 	}
 }
 
+void ALightsaber::DoDamage(class AMainCharacter* Victim)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SWFL_DoDamage);
+
+	if (Victim == nullptr)
+	{
+		return;
+	}
+
+	TRACE_SWFL_COMBAT_EVENT(Hit, GetOwner(), Victim, Victim->GetActorLocation());
+
+	// Played here and sent to the clients which did not predict the hit
+	if (CombatFXSubsystem)
+	{
+		CombatFXSubsystem->AddEvent(ECombatFXType::CFX_HIT, Victim, GetOwner(), Victim->GetActorLocation());
+	}
+	else
+	{
+		Victim->PlayHitFX(Victim->GetActorLocation());
+	}
+}
+
 void ALightsaber::IgniteLightsaber()
 {
 	zInterpSpeed = 8.f;
@@ -152,16 +485,39 @@ void ALightsaber::IgniteLightsaber()
 	// Set current state to ignited
 	bIsIgnited = true;
 
+	// Replicate again until the blade has settled back in the hilt
+	if (HasAuthority())
+	{
+		SetNetDormancy(DORM_Awake);
+	}
+
+	UpdateNetState(zScaleTarget);
+
+	TRACE_SWFL_COMBAT_EVENT(Ignite, this, GetOwner(), GetActorLocation());
+
+	// Wake up to grow the blade
+	WakeUp();
+
+	// Forget the trace of a previous ignition
+	bLastBladeTraceHit = false;
+
 	// If ignition sound is set, play it
 	if (IgniteSound)
 	{
 		IgniteSound->Play(0.f);
 	}
 
-	// If idle sound is set, play it
+	// If idle sound is set, play it (the audio subsystem decides whether it gets its own voice)
 	if (IdleSound)
 	{
-		IdleSound->Play(0.f);
+		if (AudioSubsystem)
+		{
+			AudioSubsystem->StartHum(this);
+		}
+		else
+		{
+			IdleSound->Play(0.f);
+		}
 	}
 
 	// If ignition effect is set, spawn it
@@ -187,6 +543,13 @@ void ALightsaber::ExtinguishLightsaber()
 	// Set current state to extinguished
 	bIsIgnited = false;
 
+	UpdateNetState(zScaleTarget);
+
+	TRACE_SWFL_COMBAT_EVENT(Extinguish, this, GetOwner(), GetActorLocation());
+
+	// Keep updating until the blade has retracted
+	WakeUp();
+
 	// If extinguish sound is set, play it
 	if (ExtinguishSound)
 	{
@@ -196,7 +559,14 @@ void ALightsaber::ExtinguishLightsaber()
 	// If idle sound is set, stop it
 	if (IdleSound)
 	{
-		IdleSound->Stop();
+		if (AudioSubsystem)
+		{
+			AudioSubsystem->StopHum(this);
+		}
+		else
+		{
+			IdleSound->Stop();
+		}
 	}
 
 	// If extinguish effect is set, spawn it
@@ -226,10 +596,14 @@ void ALightsaber::SpawnHiltVFX(UParticleSystem* VFX, UStaticMeshComponent* Objec
 		EPSCPoolMethod::AutoRelease,
 		true
 	);
+
+	SWFL_COUNT_FX_SPAWNED();
 }
 
 bool ALightsaber::RayCast(float& zCurrentScaleLimit, float& zCollisionScale)
 {
+	SCOPE_CYCLE_COUNTER(STAT_SWFL_RayCast);
+
 	FHitResult OutHit;
 
 	// Start point
@@ -244,32 +618,38 @@ bool ALightsaber::RayCast(float& zCurrentScaleLimit, float& zCollisionScale)
 	FCollisionQueryParams CollisionParams;
 	CollisionParams.AddIgnoredActor(this->GetOwner());
 
-	// Save hit result
-	bool bIsHit = GetWorld()->LineTraceSingleByChannel(OutHit, StartPoint, EndPoint, ECC_Visibility, CollisionParams);
+	bool bIsHit;
+
+	if (ShouldUseSyncTrace() || TraceSubsystem == nullptr)
+	{
+		SWFL_COUNT_BLADE_TRACES(1);
+
+		// Save hit result
+		bIsHit = GetWorld()->LineTraceSingleByChannel(OutHit, StartPoint, EndPoint, ECC_Visibility, CollisionParams);
+	}
+	else
+	{
+		// Queue this frame's trace and use the result of the one queued last frame
+		TraceSubsystem->RequestBladeTrace(this, StartPoint, EndPoint, CollisionParams);
+
+		bIsHit = bLastBladeTraceHit;
+		OutHit = LastBladeTraceHit;
+	}
 
 	// Check if blade is colliding
 	if (bIsHit)
 	{
 		// Update end point
-		EndPoint = StartPoint + (ForwardVector * zCurrentScaleLimit * OutHit.ImpactPoint.Dist(StartPoint, OutHit.ImpactPoint));
+		EndPoint = StartPoint + (ForwardVector * zCurrentScaleLimit * OutHit.ImpactPoint.Dist(OutHit.TraceStart, OutHit.ImpactPoint));
 
-		if (ExtinguishVFX)
+		// Clients only play the contacts of their own blades, the server sends them the others
+		if (CombatFXSubsystem)
 		{
-			UGameplayStatics::SpawnEmitterAtLocation(
-				GetWorld(),
-				ExtinguishVFX,
-				OutHit.ImpactPoint,
-				GetActorRotation(),
-				FVector(0.2f),
-				true,
-				EPSCPoolMethod::AutoRelease,
-				true
-			);
+			CombatFXSubsystem->AddEvent(ECombatFXType::CFX_IMPACT, this, GetOwner(), OutHit.ImpactPoint, OutHit.ImpactNormal);
 		}
-
-		if (DecalMI)
+		else
 		{
-			UGameplayStatics::SpawnDecalAtLocation(GetWorld(), DecalMI, FVector(15.f), OutHit.ImpactPoint, OutHit.ImpactNormal.Rotation(), 2.f);
+			PlayImpactFX(OutHit.ImpactPoint, OutHit.ImpactNormal);
 		}
 	}
 
@@ -282,30 +662,143 @@ bool ALightsaber::RayCast(float& zCurrentScaleLimit, float& zCollisionScale)
 	return bIsHit;
 }
 
+void ALightsaber::PlayImpactFX(const FVector& Location, const FVector& Normal)
+{
+	// Sparks of a continuous contact are merged and rate-limited by the impact subsystem
+	if (ExtinguishVFX && ImpactSubsystem)
+	{
+		ImpactSubsystem->AddImpact(this, ExtinguishVFX, Location, GetActorRotation(), FVector(0.2f));
+	}
+
+	// Burn marks along a drag are merged into pooled decals
+	if (DecalMI && BurnMarkSubsystem)
+	{
+		BurnMarkSubsystem->AddBurnMark(this, DecalMI, FVector(15.f), Location, Normal);
+	}
+}
+
+void ALightsaber::PlayClashFX(const FVector& Location, const FVector& Normal)
+{
+	if (ClashVFX && ImpactSubsystem)
+	{
+		ImpactSubsystem->AddImpact(this, ClashVFX, Location, Normal.IsNearlyZero() ? GetActorRotation() : Normal.Rotation(), FVector(0.2f));
+	}
+}
+
+bool ALightsaber::ShouldUseSyncTrace() const
+{
+	if (!bSyncTraceForLocalPlayer)
+	{
+		return false;
+	}
+
+	const APawn* OwnerPawn = Cast<APawn>(GetOwner());
+
+	return OwnerPawn && OwnerPawn->IsLocallyControlled() && OwnerPawn->IsPlayerControlled();
+}
+
+void ALightsaber::UpdateBladeVisibility(bool bVisible)
+{
+	if (bBladeVisible == bVisible)
+	{
+		SkippedComponentUpdates++;
+		return;
+	}
+
+	bBladeVisible = bVisible;
+
+	Light->SetVisibility(bVisible && LightTier != ELightsaberLightTier::ELT_OFF);
+	Blade->SetVisibility(bVisible);
+	Beam->SetVisibility(bVisible);
+
+	PushedComponentUpdates++;
+}
+
+void ALightsaber::SetLightTier(ELightsaberLightTier Tier)
+{
+	if (LightTier == Tier)
+	{
+		return;
+	}
+
+	LightTier = Tier;
+
+	if (Tier != ELightsaberLightTier::ELT_OFF)
+	{
+		Light->SetCastShadows(Tier == ELightsaberLightTier::ELT_FULL && bLightCastsShadows);
+	}
+
+	Light->SetVisibility(bBladeVisible && Tier != ELightsaberLightTier::ELT_OFF);
+}
+
+void ALightsaber::UpdateBladeScale(float zScale)
+{
+	// Keep the exact value for interpolation even if the component is not touched
+	zBladeScale = zScale;
+
+	const FVector BladeScale = Blade->GetRelativeScale3D();
+
+	if (FMath::IsNearlyEqual(BladeScale.Z, zScale, BladeScaleTolerance))
+	{
+		SkippedComponentUpdates++;
+		return;
+	}
+
+	Blade->SetRelativeScale3D(FVector(BladeScale.X, BladeScale.Y, zScale));
+
+	PushedComponentUpdates++;
+}
+
+void ALightsaber::UpdateLightIntensity(float Intensity)
+{
+	if (FMath::IsNearlyEqual(Light->Intensity, Intensity, LightIntensityTolerance))
+	{
+		SkippedComponentUpdates++;
+		return;
+	}
+
+	Light->SetIntensity(Intensity);
+
+	PushedComponentUpdates++;
+}
+
 // Called every frame
 void ALightsaber::Tick(float DeltaTime)
 {
+	SCOPE_CYCLE_COUNTER(STAT_SWFL_LightsaberTick);
+
 	Super::Tick(DeltaTime);
 
-	// Store blade's collision Z scale
-	float zCollisionScale;
+	// Only reached when no blade simulation drives this saber
 
 	// Track current scale on Z axis
-	float zCurrentScale = FMath::FInterpTo(Blade->GetRelativeScale3D().Z, zScaleTarget, DeltaTime, zInterpSpeed);
+	float LightIntensity;
+	bool bVisible;
+	float zCurrentScale = StepBladeScale(zBladeScale, zScaleTarget, DeltaTime, zInterpSpeed, DefaultLightIntensity, LightIntensity, bVisible);
+
+	ApplyBladeStep(zCurrentScale, bVisible, LightIntensity);
+
+	// Once the blade has settled in the hilt, sleep until the next ignition
+	if (IsBladeSettled())
+	{
+		SetActorTickEnabled(false);
+	}
+}
+
+void ALightsaber::ApplyBladeStep(float zCurrentScale, bool bVisible, float LightIntensity)
+{
+	// Store blade's collision Z scale
+	float zCollisionScale;
 
 	// If lightsaber is completely turned off, hide its components
-	if (zCurrentScale <= 0.015f)
+	if (!bVisible)
 	{
-		Light->SetVisibility(false);
-		Blade->SetVisibility(false);
-		Beam->SetVisibility(false);
+		UpdateBladeVisibility(false);
 		// Trail->SetVisibility(false);
 	}
 	else
 	{
-		Light->SetVisibility(true);
-		Blade->SetVisibility(true);
-		Beam->SetVisibility(true);
+		UpdateBladeVisibility(true);
 		// Trail->SetVisibility(true);
 
 		// Check if the saber is colliding
@@ -323,10 +816,12 @@ void ALightsaber::Tick(float DeltaTime)
 			}
 
 			// Light intensity interpolation based on collision scale
-			Light->SetIntensity(zCollisionScale * DefaultLightIntensity);
+			UpdateLightIntensity(zCollisionScale * DefaultLightIntensity);
 
 			// Blade interpolation on Z axis based on collision scale
-			Blade->SetRelativeScale3D(FVector(Blade->GetRelativeScale3D().X, Blade->GetRelativeScale3D().Y, zCollisionScale));
+			UpdateBladeScale(zCollisionScale);
+
+			UpdateNetState(zCollisionScale);
 		}
 		else
 		{
@@ -334,10 +829,41 @@ void ALightsaber::Tick(float DeltaTime)
 			zInterpSpeed = 8.f;
 
 			// Light intensity interpolation
-			Light->SetIntensity(zCurrentScale * DefaultLightIntensity);
+			UpdateLightIntensity(LightIntensity);
 
 			// Blade interpolation on Z axis
-			Blade->SetRelativeScale3D(FVector(Blade->GetRelativeScale3D().X, Blade->GetRelativeScale3D().Y, zCurrentScale));
+			UpdateBladeScale(zCurrentScale);
+
+			UpdateNetState(zScaleTarget);
 		}
 	}
-}
\ No newline at end of file
+
+	// Look for hits along the path of the blade since last frame
+	if (bIsBladeCollisionActive)
+	{
+		SweepBlade();
+	}
+
+	// A settled saber has sent its last state, the server stops considering it for replication
+	if (HasAuthority() && NetDormancy != DORM_DormantAll && IsBladeSettled())
+	{
+		SetNetDormancy(DORM_DormantAll);
+	}
+}
+
+bool ALightsaber::IsBladeSettled() const
+{
+	return !bBladeVisible && !bIsIgnited && !bIsBladeCollisionActive;
+}
+
+void ALightsaber::WakeUp()
+{
+	if (SimulationSubsystem)
+	{
+		SimulationSubsystem->WakeLightsaber(this);
+	}
+	else
+	{
+		SetActorTickEnabled(true);
+	}
+}
@@ -0,0 +1,233 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LightsaberAudioSubsystem.h"
+#include "Engine/World.h"
+#include "Kismet/GameplayStatics.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Components/AudioComponent.h"
+#include "Sound/SoundBase.h"
+#include "Lightsaber.h"
+#include "SWFLStats.h"
+
+void ULightsaberAudioSubsystem::StartHum(ALightsaber* Lightsaber)
+{
+	if (Lightsaber == nullptr)
+	{
+		return;
+	}
+
+	HummingLightsabers.AddUnique(Lightsaber);
+
+	// Assign voices on the next tick rather than starting one for every saber ignited at once
+	TimeSinceUpdate = UpdateInterval;
+}
+
+void ULightsaberAudioSubsystem::StopHum(ALightsaber* Lightsaber)
+{
+	HummingLightsabers.RemoveSwap(Lightsaber);
+
+	SetHumPlaying(Lightsaber, false);
+}
+
+bool ULightsaberAudioSubsystem::PlayHitSound(USoundBase* Sound, const FVector& Location)
+{
+	UWorld* World = GetWorld();
+
+	if (World == nullptr || Sound == nullptr)
+	{
+		return false;
+	}
+
+	if (HitSoundFrame != GFrameCounter)
+	{
+		HitSoundFrame = GFrameCounter;
+		HitSoundsThisFrame = 0;
+	}
+
+	if (HitSoundsThisFrame >= MaxHitSoundsPerFrame)
+	{
+		return false;
+	}
+
+	UAudioComponent* FreeComponent = nullptr;
+	int32 NumInArea = 0;
+
+	for (UAudioComponent* Component : HitSoundPool)
+	{
+		if (Component->IsPlaying())
+		{
+			if (FVector::DistSquared(Component->GetComponentLocation(), Location) <= FMath::Square(HitSoundAreaRadius))
+			{
+				NumInArea++;
+			}
+		}
+		else if (FreeComponent == nullptr)
+		{
+			FreeComponent = Component;
+		}
+	}
+
+	if (NumInArea >= MaxHitSoundsPerArea)
+	{
+		return false;
+	}
+
+	// Grow the pool lazily up to its cap
+	if (FreeComponent == nullptr && HitSoundPool.Num() < MaxHitSoundVoices)
+	{
+		FreeComponent = NewObject<UAudioComponent>(this);
+		FreeComponent->bAutoActivate = false;
+		FreeComponent->bAutoDestroy = false;
+		FreeComponent->bAllowSpatialization = true;
+		FreeComponent->RegisterComponentWithWorld(World);
+
+		HitSoundPool.Add(FreeComponent);
+	}
+
+	if (FreeComponent == nullptr)
+	{
+		return false;
+	}
+
+	FreeComponent->SetSound(Sound);
+	FreeComponent->SetWorldLocation(Location);
+	FreeComponent->Play(0.f);
+
+	HitSoundsThisFrame++;
+
+	return true;
+}
+
+void ULightsaberAudioSubsystem::Deinitialize()
+{
+	for (UAudioComponent* Component : HitSoundPool)
+	{
+		if (Component)
+		{
+			Component->DestroyComponent();
+		}
+	}
+
+	HitSoundPool.Reset();
+	HummingLightsabers.Reset();
+
+	Super::Deinitialize();
+}
+
+void ULightsaberAudioSubsystem::Tick(float DeltaTime)
+{
+	TimeSinceUpdate += DeltaTime;
+
+	if (TimeSinceUpdate < UpdateInterval)
+	{
+		return;
+	}
+
+	TimeSinceUpdate = 0.f;
+
+	// Hums are assigned around the first local player's camera, which is where the listener sits
+	APlayerCameraManager* CameraManager = UGameplayStatics::GetPlayerCameraManager(GetWorld(), 0);
+
+	if (CameraManager == nullptr)
+	{
+		return;
+	}
+
+	const FVector ListenerLocation = CameraManager->GetCameraLocation();
+
+	HumCandidates.Reset();
+
+	for (int32 Index = HummingLightsabers.Num() - 1; Index >= 0; --Index)
+	{
+		ALightsaber* Lightsaber = HummingLightsabers[Index].Get();
+
+		if (Lightsaber == nullptr)
+		{
+			HummingLightsabers.RemoveAtSwap(Index);
+			continue;
+		}
+
+		const FVector Location = Lightsaber->GetActorLocation();
+		HumCandidates.Add({ Lightsaber, Location, FVector::DistSquared(Location, ListenerLocation), false });
+	}
+
+	// Nearest sabers get a voice first and lead the ones around them
+	HumCandidates.Sort([](const FHumCandidate& A, const FHumCandidate& B) { return A.DistanceSquared < B.DistanceSquared; });
+
+	NumHumVoices = 0;
+
+	for (int32 Leader = 0; Leader < HumCandidates.Num(); ++Leader)
+	{
+		FHumCandidate& Candidate = HumCandidates[Leader];
+
+		if (Candidate.bAssigned)
+		{
+			continue;
+		}
+
+		Candidate.bAssigned = true;
+
+		const bool bAudible = NumHumVoices < MaxHumVoices && Candidate.DistanceSquared <= FMath::Square(MaxHumDistance);
+
+		if (bAudible)
+		{
+			NumHumVoices++;
+		}
+
+		SetHumPlaying(Candidate.Lightsaber, bAudible);
+
+		// Sabers around the leader are heard through its voice
+		for (int32 Follower = Leader + 1; Follower < HumCandidates.Num(); ++Follower)
+		{
+			FHumCandidate& Other = HumCandidates[Follower];
+
+			if (!Other.bAssigned && FVector::DistSquared(Other.Location, Candidate.Location) <= FMath::Square(HumShareRadius))
+			{
+				Other.bAssigned = true;
+				SetHumPlaying(Other.Lightsaber, false);
+			}
+		}
+	}
+
+	SET_DWORD_STAT(STAT_SWFL_HumVoices, NumHumVoices);
+}
+
+void ULightsaberAudioSubsystem::SetHumPlaying(ALightsaber* Lightsaber, bool bPlaying)
+{
+	UAudioComponent* IdleSound = Lightsaber ? Lightsaber->GetIdleSound() : nullptr;
+
+	if (IdleSound == nullptr)
+	{
+		return;
+	}
+
+	if (bPlaying && !IdleSound->IsPlaying())
+	{
+		IdleSound->FadeIn(HumFadeTime);
+	}
+	else if (!bPlaying && IdleSound->IsPlaying())
+	{
+		IdleSound->FadeOut(HumFadeTime, 0.f);
+	}
+}
+
+bool ULightsaberAudioSubsystem::IsTickable() const
+{
+	return HummingLightsabers.Num() > 0;
+}
+
+ETickableTickType ULightsaberAudioSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+UWorld* ULightsaberAudioSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+TStatId ULightsaberAudioSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(ULightsaberAudioSubsystem, STATGROUP_Tickables);
+}
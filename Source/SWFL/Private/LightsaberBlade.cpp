@@ -0,0 +1,35 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LightsaberBlade.h"
+
+FLightsaberNetState FLightsaberNetState::Quantize(bool bInIgnited, float InBladeLength, float MaxScale)
+{
+	FLightsaberNetState State;
+	State.bIgnited = bInIgnited;
+	State.BladeLength = MaxScale > 0.f ? static_cast<uint8>(FMath::RoundToInt(FMath::Clamp(InBladeLength / MaxScale, 0.f, 1.f) * 255.f)) : 0;
+
+	return State;
+}
+
+void FLightsaberNetState::Apply(ILightsaberBlade& Blade, float MaxScale) const
+{
+	// The owning client may have predicted the flip already
+	if (bIgnited != Blade.GetIsIgnited())
+	{
+		if (bIgnited)
+		{
+			Blade.IgniteLightsaber();
+		}
+		else
+		{
+			Blade.ExtinguishLightsaber();
+		}
+	}
+
+	// Grow or shrink towards the server's blade, local traces still clamp it against local geometry
+	if (bIgnited)
+	{
+		Blade.SetBladeScaleTarget((BladeLength / 255.f) * MaxScale);
+	}
+}
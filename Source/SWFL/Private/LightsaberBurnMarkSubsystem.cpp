@@ -0,0 +1,202 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LightsaberBurnMarkSubsystem.h"
+#include "Engine/World.h"
+#include "Components/DecalComponent.h"
+#include "Materials/MaterialInterface.h"
+#include "SWFLStats.h"
+
+void ULightsaberBurnMarkSubsystem::AddBurnMark(const AActor* Source, UMaterialInterface* Material, const FVector& DecalSize, const FVector& Location, const FVector& Normal)
+{
+	UWorld* World = GetWorld();
+
+	if (World == nullptr || Source == nullptr || Material == nullptr || MaxBurnMarks <= 0)
+	{
+		return;
+	}
+
+	const float Now = World->GetTimeSeconds();
+
+	FBurnStroke* Stroke = Strokes.FindByPredicate([Source](const FBurnStroke& Other) { return Other.Source == Source; });
+
+	// Continue the stroke if its decal has not been recycled and the contact moved along the same surface
+	if (Stroke && Slots[Stroke->Slot].Generation == Stroke->Generation && Slots[Stroke->Slot].bLive
+		&& (Now - Stroke->LastTime) <= MergeTime
+		&& FVector::DistSquared(Location, Stroke->EndPoint) <= FMath::Square(MergeDistance)
+		&& FVector::DotProduct(Normal, Stroke->Normal) >= MinNormalDot
+		&& FVector::DistSquared(Location, Stroke->StartPoint) <= FMath::Square(MaxStrokeLength))
+	{
+		Stroke->LastTime = Now;
+		Slots[Stroke->Slot].LastTouchTime = Now;
+
+		if (FVector::DistSquared(Location, Stroke->EndPoint) >= FMath::Square(MinStrokeStep))
+		{
+			Stroke->EndPoint = Location;
+			PlaceDecal(*Stroke);
+		}
+
+		return;
+	}
+
+	const int32 Slot = AcquireSlot(Material);
+
+	if (Slot == INDEX_NONE)
+	{
+		return;
+	}
+
+	if (Stroke == nullptr)
+	{
+		Stroke = &Strokes.AddDefaulted_GetRef();
+		Stroke->Source = Source;
+	}
+
+	Stroke->Slot = Slot;
+	Stroke->Generation = Slots[Slot].Generation;
+	Stroke->StartPoint = Location;
+	Stroke->EndPoint = Location;
+	Stroke->Normal = Normal;
+	Stroke->DecalSize = DecalSize;
+	Stroke->LastTime = Now;
+
+	Slots[Slot].LastTouchTime = Now;
+
+	PlaceDecal(*Stroke);
+}
+
+void ULightsaberBurnMarkSubsystem::Deinitialize()
+{
+	for (UDecalComponent* Decal : Decals)
+	{
+		if (Decal)
+		{
+			Decal->DestroyComponent();
+		}
+	}
+
+	Decals.Reset();
+	Slots.Reset();
+	Strokes.Reset();
+	NextSlot = 0;
+	DEC_DWORD_STAT_BY(STAT_SWFL_BurnMarksAlive, NumLiveBurnMarks);
+	NumLiveBurnMarks = 0;
+
+	Super::Deinitialize();
+}
+
+int32 ULightsaberBurnMarkSubsystem::AcquireSlot(UMaterialInterface* Material)
+{
+	UWorld* World = GetWorld();
+
+	// Grow the pool lazily until it reaches its cap, then wrap around to the oldest mark
+	if (Decals.Num() < MaxBurnMarks && NextSlot == Decals.Num())
+	{
+		UDecalComponent* Decal = NewObject<UDecalComponent>(this);
+		Decal->bAllowAnyoneToDestroyMe = true;
+		Decal->SetUsingAbsoluteScale(true);
+		Decal->SetDecalMaterial(Material);
+		Decal->SetVisibility(false);
+		Decal->RegisterComponentWithWorld(World);
+
+		Decals.Add(Decal);
+		Slots.AddDefaulted();
+	}
+
+	if (!Decals.IsValidIndex(NextSlot))
+	{
+		NextSlot = 0;
+	}
+
+	if (!Decals.IsValidIndex(NextSlot))
+	{
+		return INDEX_NONE;
+	}
+
+	const int32 Slot = NextSlot;
+	NextSlot = (NextSlot + 1) % MaxBurnMarks;
+
+	UDecalComponent* Decal = Decals[Slot];
+
+	if (Decal->GetDecalMaterial() != Material)
+	{
+		Decal->SetDecalMaterial(Material);
+	}
+
+	FBurnMarkSlot& BurnMark = Slots[Slot];
+
+	if (!BurnMark.bLive)
+	{
+		BurnMark.bLive = true;
+		NumLiveBurnMarks++;
+		INC_DWORD_STAT(STAT_SWFL_BurnMarksAlive);
+		Decal->SetVisibility(true);
+	}
+
+	// Strokes still pointing at this slot no longer own it
+	BurnMark.Generation++;
+
+	return Slot;
+}
+
+void ULightsaberBurnMarkSubsystem::PlaceDecal(const FBurnStroke& Stroke)
+{
+	UDecalComponent* Decal = Decals[Stroke.Slot];
+
+	const FVector Drag = Stroke.EndPoint - Stroke.StartPoint;
+	const FVector DragOnSurface = FVector::VectorPlaneProject(Drag, Stroke.Normal);
+	const float HalfLength = DragOnSurface.Size() * 0.5f;
+
+	// Decal projects along X, stretch it on Y along the drag
+	const FRotator Rotation = HalfLength > KINDA_SMALL_NUMBER
+		? FRotationMatrix::MakeFromXY(Stroke.Normal, DragOnSurface).Rotator()
+		: Stroke.Normal.Rotation();
+
+	Decal->DecalSize = FVector(Stroke.DecalSize.X, Stroke.DecalSize.Y + HalfLength, Stroke.DecalSize.Z);
+	Decal->SetWorldLocationAndRotation((Stroke.StartPoint + Stroke.EndPoint) * 0.5f, Rotation);
+	Decal->MarkRenderStateDirty();
+}
+
+void ULightsaberBurnMarkSubsystem::Tick(float DeltaTime)
+{
+	const float Now = GetWorld()->GetTimeSeconds();
+
+	for (int32 Slot = 0; Slot < Slots.Num(); ++Slot)
+	{
+		FBurnMarkSlot& BurnMark = Slots[Slot];
+
+		if (BurnMark.bLive && (Now - BurnMark.LastTouchTime) > BurnMarkLifetime)
+		{
+			BurnMark.bLive = false;
+			NumLiveBurnMarks--;
+			DEC_DWORD_STAT(STAT_SWFL_BurnMarksAlive);
+			Decals[Slot]->SetVisibility(false);
+		}
+	}
+
+	// Forget strokes whose source stopped burning
+	Strokes.RemoveAllSwap([Now, this](const FBurnStroke& Stroke)
+	{
+		return !Stroke.Source.IsValid() || (Now - Stroke.LastTime) > MergeTime;
+	});
+}
+
+bool ULightsaberBurnMarkSubsystem::IsTickable() const
+{
+	return NumLiveBurnMarks > 0 || Strokes.Num() > 0;
+}
+
+ETickableTickType ULightsaberBurnMarkSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+UWorld* ULightsaberBurnMarkSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+TStatId ULightsaberBurnMarkSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(ULightsaberBurnMarkSubsystem, STATGROUP_Tickables);
+}
@@ -0,0 +1,268 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LightsaberClashSubsystem.h"
+#include "Engine/World.h"
+#include "Lightsaber.h"
+#include "LightsaberSimulationSubsystem.h"
+#include "CombatFXSubsystem.h"
+#include "SWFLStats.h"
+
+namespace LightsaberClash
+{
+	// Segments of four pairs in structure-of-arrays form, one lane per pair
+	struct FSegmentPairs4
+	{
+		float P1[3][4];
+		float Q1[3][4];
+		float P2[3][4];
+		float Q2[3][4];
+	};
+
+	struct FClosestPoints4
+	{
+		float S[4];
+		float T[4];
+		float DistanceSquared[4];
+	};
+
+	FORCEINLINE VectorRegister Dot3(const VectorRegister Ax, const VectorRegister Ay, const VectorRegister Az, const VectorRegister Bx, const VectorRegister By, const VectorRegister Bz)
+	{
+		return VectorMultiplyAdd(Ax, Bx, VectorMultiplyAdd(Ay, By, VectorMultiply(Az, Bz)));
+	}
+
+	FORCEINLINE VectorRegister Clamp01(const VectorRegister V)
+	{
+		return VectorMin(VectorMax(V, VectorZero()), VectorOne());
+	}
+
+	// Closest points between segments P1Q1 and P2Q2 for four pairs at once (Ericson, Real-Time Collision Detection 5.1.9)
+	// S and T are the parameters of the closest points along each segment
+	void ClosestPointsSegmentSegment4(const FSegmentPairs4& In, FClosestPoints4& Out)
+	{
+		const VectorRegister Epsilon = VectorSetFloat1(KINDA_SMALL_NUMBER);
+
+		VectorRegister P1[3], D1[3], P2[3], D2[3], R[3];
+
+		for (int32 Axis = 0; Axis < 3; ++Axis)
+		{
+			P1[Axis] = VectorLoad(In.P1[Axis]);
+			P2[Axis] = VectorLoad(In.P2[Axis]);
+			D1[Axis] = VectorSubtract(VectorLoad(In.Q1[Axis]), P1[Axis]);
+			D2[Axis] = VectorSubtract(VectorLoad(In.Q2[Axis]), P2[Axis]);
+			R[Axis] = VectorSubtract(P1[Axis], P2[Axis]);
+		}
+
+		const VectorRegister A = VectorMax(Dot3(D1[0], D1[1], D1[2], D1[0], D1[1], D1[2]), Epsilon);
+		const VectorRegister E = VectorMax(Dot3(D2[0], D2[1], D2[2], D2[0], D2[1], D2[2]), Epsilon);
+		const VectorRegister F = Dot3(D2[0], D2[1], D2[2], R[0], R[1], R[2]);
+		const VectorRegister C = Dot3(D1[0], D1[1], D1[2], R[0], R[1], R[2]);
+		const VectorRegister B = Dot3(D1[0], D1[1], D1[2], D2[0], D2[1], D2[2]);
+
+		// Parallel segments have no unique closest point, start from S = 0
+		const VectorRegister Denom = VectorSubtract(VectorMultiply(A, E), VectorMultiply(B, B));
+		const VectorRegister bNotParallel = VectorCompareGT(Denom, Epsilon);
+		const VectorRegister SafeDenom = VectorMax(Denom, Epsilon);
+
+		VectorRegister S = VectorSelect(bNotParallel, Clamp01(VectorDivide(VectorSubtract(VectorMultiply(B, F), VectorMultiply(C, E)), SafeDenom)), VectorZero());
+		VectorRegister T = VectorDivide(VectorMultiplyAdd(B, S, F), E);
+
+		// T outside of the second segment, clamp it and recompute S for the clamped end
+		const VectorRegister bTBelow = VectorCompareGT(VectorZero(), T);
+		const VectorRegister bTAbove = VectorCompareGT(T, VectorOne());
+		const VectorRegister SBelow = Clamp01(VectorDivide(VectorNegate(C), A));
+		const VectorRegister SAbove = Clamp01(VectorDivide(VectorSubtract(B, C), A));
+
+		S = VectorSelect(bTBelow, SBelow, VectorSelect(bTAbove, SAbove, S));
+		T = Clamp01(T);
+
+		VectorRegister DistanceSquared = VectorZero();
+
+		for (int32 Axis = 0; Axis < 3; ++Axis)
+		{
+			const VectorRegister Closest1 = VectorMultiplyAdd(D1[Axis], S, P1[Axis]);
+			const VectorRegister Closest2 = VectorMultiplyAdd(D2[Axis], T, P2[Axis]);
+			const VectorRegister Delta = VectorSubtract(Closest1, Closest2);
+			DistanceSquared = VectorMultiplyAdd(Delta, Delta, DistanceSquared);
+		}
+
+		VectorStore(S, Out.S);
+		VectorStore(T, Out.T);
+		VectorStore(DistanceSquared, Out.DistanceSquared);
+	}
+
+	FORCEINLINE uint64 MakePairKey(const ALightsaber* A, const ALightsaber* B)
+	{
+		const uint32 IdA = A->GetUniqueID();
+		const uint32 IdB = B->GetUniqueID();
+
+		return IdA < IdB ? (uint64(IdA) << 32) | IdB : (uint64(IdB) << 32) | IdA;
+	}
+}
+
+void ULightsaberClashSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SWFL_Clash);
+
+	using namespace LightsaberClash;
+
+	ULightsaberSimulationSubsystem* Simulation = GetWorld()->GetSubsystem<ULightsaberSimulationSubsystem>();
+
+	if (Simulation == nullptr)
+	{
+		return;
+	}
+
+	// Clash sparks are played and sent to clients through the combat effects
+	UCombatFXSubsystem* CombatFX = GetWorld()->GetSubsystem<UCombatFXSubsystem>();
+
+	const float InvDeltaTime = DeltaTime > KINDA_SMALL_NUMBER ? 1.f / DeltaTime : 0.f;
+
+	Proxies.Reset();
+	CurrentPoses.Reset();
+
+	// Every visible blade is awake in the simulation, blade components do not clash
+	for (ILightsaberBlade* Blade : Simulation->GetAwakeBlades())
+	{
+		ALightsaber* Lightsaber = Cast<ALightsaber>(Blade->_getUObject());
+
+		if (Lightsaber == nullptr || !Lightsaber->IsBladeVisible())
+		{
+			continue;
+		}
+
+		FBladeProxy& Proxy = Proxies.AddDefaulted_GetRef();
+		Proxy.Lightsaber = Lightsaber;
+		Proxy.Owner = Lightsaber->GetOwner();
+		Proxy.Radius = Lightsaber->GetBladeRadius();
+		Lightsaber->GetBladeSegment(Proxy.Base, Proxy.Tip);
+
+		const FBladePose* LastPose = LastPoses.Find(Lightsaber);
+		Proxy.BaseVelocity = LastPose ? (Proxy.Base - LastPose->Base) * InvDeltaTime : FVector::ZeroVector;
+		Proxy.TipVelocity = LastPose ? (Proxy.Tip - LastPose->Tip) * InvDeltaTime : FVector::ZeroVector;
+
+		Proxy.Bounds = FBox(Proxy.Base.ComponentMin(Proxy.Tip), Proxy.Base.ComponentMax(Proxy.Tip)).ExpandBy(Proxy.Radius);
+
+		CurrentPoses.Add(Lightsaber, FBladePose{ Proxy.Base, Proxy.Tip });
+	}
+
+	Swap(LastPoses, CurrentPoses);
+
+	// Broadphase, sort blades along X and only pair those whose bounds overlap
+	Proxies.Sort([](const FBladeProxy& A, const FBladeProxy& B) { return A.Bounds.Min.X < B.Bounds.Min.X; });
+
+	CandidatePairs.Reset();
+
+	for (int32 First = 0; First < Proxies.Num(); ++First)
+	{
+		const FBladeProxy& A = Proxies[First];
+
+		for (int32 Second = First + 1; Second < Proxies.Num() && Proxies[Second].Bounds.Min.X <= A.Bounds.Max.X; ++Second)
+		{
+			const FBladeProxy& B = Proxies[Second];
+
+			// Blades of one duelist cross all the time during combos
+			if (A.Owner == B.Owner && A.Owner != nullptr)
+			{
+				continue;
+			}
+
+			if (A.Bounds.Intersect(B.Bounds))
+			{
+				CandidatePairs.Emplace(First, Second);
+			}
+		}
+	}
+
+	// Narrowphase, four pairs per batch
+	CurrentContacts.Reset();
+
+	for (int32 BatchStart = 0; BatchStart < CandidatePairs.Num(); BatchStart += 4)
+	{
+		const int32 BatchNum = FMath::Min(4, CandidatePairs.Num() - BatchStart);
+
+		FSegmentPairs4 Segments;
+		FClosestPoints4 Closest;
+
+		for (int32 Lane = 0; Lane < 4; ++Lane)
+		{
+			// Unused lanes repeat the first pair of the batch
+			const TPair<int32, int32>& Pair = CandidatePairs[BatchStart + (Lane < BatchNum ? Lane : 0)];
+			const FBladeProxy& A = Proxies[Pair.Key];
+			const FBladeProxy& B = Proxies[Pair.Value];
+
+			for (int32 Axis = 0; Axis < 3; ++Axis)
+			{
+				Segments.P1[Axis][Lane] = A.Base[Axis];
+				Segments.Q1[Axis][Lane] = A.Tip[Axis];
+				Segments.P2[Axis][Lane] = B.Base[Axis];
+				Segments.Q2[Axis][Lane] = B.Tip[Axis];
+			}
+		}
+
+		ClosestPointsSegmentSegment4(Segments, Closest);
+
+		for (int32 Lane = 0; Lane < BatchNum; ++Lane)
+		{
+			const TPair<int32, int32>& Pair = CandidatePairs[BatchStart + Lane];
+			const FBladeProxy& A = Proxies[Pair.Key];
+			const FBladeProxy& B = Proxies[Pair.Value];
+
+			if (Closest.DistanceSquared[Lane] > FMath::Square(A.Radius + B.Radius))
+			{
+				continue;
+			}
+
+			const uint64 Key = MakePairKey(A.Lightsaber, B.Lightsaber);
+			CurrentContacts.Add(Key);
+
+			// Blades already touching last frame are the same clash
+			if (LastContacts.Contains(Key))
+			{
+				continue;
+			}
+
+			const float S = Closest.S[Lane];
+			const float T = Closest.T[Lane];
+
+			const FVector PointA = FMath::Lerp(A.Base, A.Tip, S);
+			const FVector PointB = FMath::Lerp(B.Base, B.Tip, T);
+			const FVector VelocityA = FMath::Lerp(A.BaseVelocity, A.TipVelocity, S);
+			const FVector VelocityB = FMath::Lerp(B.BaseVelocity, B.TipVelocity, T);
+
+			TRACE_SWFL_COMBAT_EVENT(Clash, A.Lightsaber, B.Lightsaber, (PointA + PointB) * 0.5f);
+
+			OnClash.Broadcast(A.Lightsaber, B.Lightsaber, (PointA + PointB) * 0.5f, VelocityA - VelocityB);
+
+			if (CombatFX)
+			{
+				CombatFX->AddEvent(ECombatFXType::CFX_CLASH, A.Lightsaber, A.Owner, (PointA + PointB) * 0.5f, (VelocityA - VelocityB).GetSafeNormal());
+			}
+		}
+	}
+
+	Swap(LastContacts, CurrentContacts);
+}
+
+bool ULightsaberClashSubsystem::IsTickable() const
+{
+	// Keep ticking one more frame after the last blade went out, to forget its pose and contacts
+	const ULightsaberSimulationSubsystem* Simulation = GetWorld()->GetSubsystem<ULightsaberSimulationSubsystem>();
+
+	return (Simulation && Simulation->GetNumAwakeLightsabers() > 0) || LastPoses.Num() > 0;
+}
+
+ETickableTickType ULightsaberClashSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+UWorld* ULightsaberClashSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+TStatId ULightsaberClashSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(ULightsaberClashSubsystem, STATGROUP_Tickables);
+}
@@ -0,0 +1,395 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LightsaberComponent.h"
+#include "Components/PointLightComponent.h"
+#include "Engine/World.h"
+#include "Lightsaber.h"
+#include "MainCharacter.h"
+#include "LightsaberSimulationSubsystem.h"
+#include "LightsaberTraceSubsystem.h"
+#include "CombatFXSubsystem.h"
+#include "SWFLStats.h"
+#include "Net/UnrealNetwork.h"
+
+ULightsaberComponent::ULightsaberComponent()
+{
+	// Stepped by the blade simulation, the component tick only runs without one
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+	PrimaryComponentTick.TickGroup = TG_PostPhysics;
+
+	SetIsReplicatedByDefault(true);
+
+	// Hits are swept, the blade mesh itself never collides
+	SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	SetGenerateOverlapEvents(false);
+	CanCharacterStepUpOn = ECB_No;
+	CastShadow = false;
+
+	// Blade starts hidden and retracted, 10 units above the hand like the saber actor's blade above its hilt
+	SetRelativeLocation(FVector(0, 0, 10));
+	SetRelativeScale3D(FVector(1, 1, 0));
+	SetVisibility(false);
+
+	zMaxScale = 1.f;
+	engineBladeScale = 80.f;
+	BaseBladeSocket = "Base";
+	TipBladeSocket = "Tip";
+
+	// Same sweep resolution as the saber actor
+	BladeSweepRadius = 4.f;
+	MaxSubstepAngle = 10.f;
+	MaxSubstepDistance = 20.f;
+	MaxSubsteps = 8;
+
+	bUseLight = false;
+	LightColor = FLinearColor::White;
+	DefaultLightIntensity = 500.f;
+	Light = nullptr;
+	SimulationSubsystem = nullptr;
+	TraceSubsystem = nullptr;
+
+	bIsIgnited = false;
+	bBladeVisible = false;
+	bIsBladeCollisionActive = false;
+	zScaleTarget = 0.f;
+	zInterpSpeed = 8.f;
+	zBladeScale = 0.f;
+}
+
+void ULightsaberComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	SimulationSubsystem = GetWorld()->GetSubsystem<ULightsaberSimulationSubsystem>();
+	TraceSubsystem = GetWorld()->GetSubsystem<ULightsaberTraceSubsystem>();
+
+	if (bUseLight && GetOwner())
+	{
+		// Attached next to the blade rather than to it, so scaling the blade does not move the light
+		Light = NewObject<UPointLightComponent>(GetOwner());
+		Light->SetupAttachment(GetAttachParent(), GetAttachSocketName());
+		Light->SetRelativeLocation(GetRelativeLocation() + FVector(0, 0, engineBladeScale * 0.5f));
+		Light->SetLightColor(LightColor);
+		Light->SetCastShadows(false);
+		Light->SetIntensity(0.f);
+		Light->SetVisibility(false);
+		Light->RegisterComponent();
+	}
+}
+
+void ULightsaberComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (SimulationSubsystem)
+	{
+		SimulationSubsystem->SleepLightsaber(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void ULightsaberComponent::OnComponentDestroyed(bool bDestroyingHierarchy)
+{
+	if (Light)
+	{
+		Light->DestroyComponent();
+		Light = nullptr;
+	}
+
+	Super::OnComponentDestroyed(bDestroyingHierarchy);
+}
+
+void ULightsaberComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(ULightsaberComponent, NetState);
+}
+
+void ULightsaberComponent::OnRep_NetState()
+{
+	NetState.Apply(*this, zMaxScale);
+}
+
+void ULightsaberComponent::SetBladeScaleTarget(float ScaleTarget)
+{
+	zScaleTarget = ScaleTarget;
+	WakeUp();
+}
+
+void ULightsaberComponent::UpdateNetState(float BladeLength)
+{
+	if (GetOwner() == nullptr || !GetOwner()->HasAuthority())
+	{
+		return;
+	}
+
+	// Replicated with the owner, which compares the properties itself
+	NetState = FLightsaberNetState::Quantize(bIsIgnited, BladeLength, zMaxScale);
+}
+
+void ULightsaberComponent::IgniteLightsaber()
+{
+	zInterpSpeed = 8.f;
+	zScaleTarget = zMaxScale;
+	bIsIgnited = true;
+
+	UpdateNetState(zScaleTarget);
+
+	TRACE_SWFL_COMBAT_EVENT(Ignite, this, GetOwner(), GetComponentLocation());
+
+	WakeUp();
+}
+
+void ULightsaberComponent::ExtinguishLightsaber()
+{
+	zInterpSpeed = 8.f;
+	zScaleTarget = 0.f;
+	bIsIgnited = false;
+
+	UpdateNetState(zScaleTarget);
+
+	TRACE_SWFL_COMBAT_EVENT(Extinguish, this, GetOwner(), GetComponentLocation());
+
+	WakeUp();
+}
+
+void ULightsaberComponent::ActivateBladeCollision()
+{
+	bIsBladeCollisionActive = true;
+
+	GetBladeSegment(PrevSweepBase, PrevSweepTip);
+	SweptActors.Reset();
+
+	WakeUp();
+}
+
+void ULightsaberComponent::DeactivateBladeCollision()
+{
+	bIsBladeCollisionActive = false;
+	SweptActors.Reset();
+}
+
+void ULightsaberComponent::SetBladeCollisionActive(bool bActive)
+{
+	if (bActive)
+	{
+		ActivateBladeCollision();
+	}
+	else
+	{
+		DeactivateBladeCollision();
+	}
+}
+
+void ULightsaberComponent::GetBladeSegment(FVector& OutBase, FVector& OutTip) const
+{
+	OutBase = GetSocketLocation(BaseBladeSocket);
+	OutTip = GetSocketLocation(TipBladeSocket);
+}
+
+void ULightsaberComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SWFL_LightsaberTick);
+
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	float LightIntensity;
+	bool bVisible;
+	const float zCurrentScale = ALightsaber::StepBladeScale(zBladeScale, zScaleTarget, DeltaTime, zInterpSpeed, DefaultLightIntensity, LightIntensity, bVisible);
+
+	ApplyBladeStep(zCurrentScale, bVisible, LightIntensity);
+
+	if (IsBladeSettled())
+	{
+		SetComponentTickEnabled(false);
+	}
+}
+
+void ULightsaberComponent::ApplyBladeStep(float zCurrentScale, bool bVisible, float LightIntensity)
+{
+	SetBladeVisible(bVisible);
+
+	if (bVisible)
+	{
+		float zCollisionScale;
+
+		// Clamp the blade against geometry, without the interpolation delay while ignited
+		if (RayCast(zCollisionScale))
+		{
+			zInterpSpeed = bIsIgnited ? 1000.f : 8.f;
+			zCurrentScale = zCollisionScale;
+			LightIntensity = zCollisionScale * DefaultLightIntensity;
+
+			UpdateNetState(zCollisionScale);
+		}
+		else
+		{
+			zInterpSpeed = 8.f;
+
+			UpdateNetState(zScaleTarget);
+		}
+
+		const FVector BladeScale = GetRelativeScale3D();
+
+		if (!FMath::IsNearlyEqual(BladeScale.Z, zCurrentScale, 0.001f))
+		{
+			SetRelativeScale3D(FVector(BladeScale.X, BladeScale.Y, zCurrentScale));
+		}
+
+		if (Light)
+		{
+			Light->SetIntensity(LightIntensity);
+		}
+	}
+
+	// Keep the exact value for interpolation, clamped by a collision if there was one
+	zBladeScale = zCurrentScale;
+
+	if (bIsBladeCollisionActive && ShouldSweepBlade())
+	{
+		SweepBlade();
+	}
+}
+
+bool ULightsaberComponent::IsBladeSettled() const
+{
+	return !bBladeVisible && !bIsIgnited && !bIsBladeCollisionActive;
+}
+
+void ULightsaberComponent::WakeUp()
+{
+	if (SimulationSubsystem)
+	{
+		SimulationSubsystem->WakeLightsaber(this);
+	}
+	else
+	{
+		SetComponentTickEnabled(true);
+	}
+}
+
+bool ULightsaberComponent::RayCast(float& OutCollisionScale)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SWFL_RayCast);
+
+	const FVector StartPoint = GetSocketLocation(BaseBladeSocket);
+	const FVector EndPoint = StartPoint + GetUpVector() * zScaleTarget * engineBladeScale;
+
+	FCollisionQueryParams CollisionParams(SCENE_QUERY_STAT(LightsaberComponentTrace), false, GetOwner());
+
+	bool bIsHit;
+	FHitResult OutHit;
+
+	if (TraceSubsystem == nullptr)
+	{
+		SWFL_COUNT_BLADE_TRACES(1);
+
+		bIsHit = GetWorld()->LineTraceSingleByChannel(OutHit, StartPoint, EndPoint, ECC_Visibility, CollisionParams);
+	}
+	else
+	{
+		TraceSubsystem->RequestBladeTrace(this, StartPoint, EndPoint, CollisionParams);
+
+		bIsHit = bLastBladeTraceHit;
+		OutHit = LastBladeTraceHit;
+	}
+
+	if (!bIsHit)
+	{
+		return false;
+	}
+
+	OutCollisionScale = FVector::Dist(OutHit.TraceStart, OutHit.ImpactPoint) / engineBladeScale;
+
+	return true;
+}
+
+bool ULightsaberComponent::ShouldSweepBlade() const
+{
+	const APawn* Wielder = Cast<APawn>(GetOwner());
+
+	if (Wielder == nullptr)
+	{
+		return false;
+	}
+
+	return Wielder->HasAuthority() || (Wielder->IsLocallyControlled() && Wielder->IsPlayerControlled());
+}
+
+void ULightsaberComponent::SweepBlade()
+{
+	SCOPE_CYCLE_COUNTER(STAT_SWFL_SweepBlade);
+
+	FVector BasePoint;
+	FVector TipPoint;
+	GetBladeSegment(BasePoint, TipPoint);
+
+	FCollisionQueryParams CollisionParams(SCENE_QUERY_STAT(LightsaberSweep), false, GetOwner());
+
+	TArray<AActor*> HitActors;
+	ALightsaber::SweepBladeArc(GetWorld(), PrevSweepBase, PrevSweepTip, BasePoint, TipPoint, BladeSweepRadius, MaxSubstepAngle, MaxSubstepDistance, MaxSubsteps, CollisionParams, HitActors);
+
+	for (AActor* HitActor : HitActors)
+	{
+		OnBladeHit(HitActor);
+	}
+
+	PrevSweepBase = BasePoint;
+	PrevSweepTip = TipPoint;
+}
+
+void ULightsaberComponent::OnBladeHit(AActor* OtherActor)
+{
+	AMainCharacter* Victim = Cast<AMainCharacter>(OtherActor);
+	AMainCharacter* Wielder = Cast<AMainCharacter>(GetOwner());
+
+	if (Victim == nullptr || Wielder == nullptr || Victim == Wielder || SweptActors.Contains(Victim))
+	{
+		return;
+	}
+
+	SweptActors.Add(Victim);
+
+	Wielder->HandleBladeHit(Wielder->GetBladeSide(this), Victim);
+}
+
+void ULightsaberComponent::DoDamage(AMainCharacter* Victim)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SWFL_DoDamage);
+
+	if (Victim == nullptr)
+	{
+		return;
+	}
+
+	TRACE_SWFL_COMBAT_EVENT(Hit, GetOwner(), Victim, Victim->GetActorLocation());
+
+	// Played here and sent to the clients
+	if (UCombatFXSubsystem* CombatFX = GetWorld()->GetSubsystem<UCombatFXSubsystem>())
+	{
+		CombatFX->AddEvent(ECombatFXType::CFX_HIT, Victim, GetOwner(), Victim->GetActorLocation());
+	}
+	else
+	{
+		Victim->PlayHitFX(Victim->GetActorLocation());
+	}
+}
+
+void ULightsaberComponent::SetBladeVisible(bool bVisible)
+{
+	if (bBladeVisible == bVisible)
+	{
+		return;
+	}
+
+	bBladeVisible = bVisible;
+
+	SetVisibility(bVisible);
+
+	if (Light)
+	{
+		Light->SetVisibility(bVisible);
+	}
+}
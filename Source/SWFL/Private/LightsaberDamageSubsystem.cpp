@@ -0,0 +1,114 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LightsaberDamageSubsystem.h"
+#include "MainCharacter.h"
+#include "SWFLStats.h"
+
+bool ULightsaberDamageSubsystem::QueueHit(ILightsaberBlade* Blade, AActor* Attacker, int32 SwingId, AMainCharacter* Victim)
+{
+	if (Blade == nullptr || Attacker == nullptr || Victim == nullptr)
+	{
+		return false;
+	}
+
+	FSwingHits& Swing = SwingHits.FindOrAdd(Attacker);
+
+	// A new swing starts with a clean list of victims
+	if (Swing.SwingId != SwingId)
+	{
+		Swing.SwingId = SwingId;
+		Swing.Victims.Reset();
+	}
+
+	if (Swing.Victims.Contains(Victim))
+	{
+		return false;
+	}
+
+	Swing.Victims.Add(Victim);
+
+	FPendingHit& Hit = PendingHits.AddDefaulted_GetRef();
+	Hit.Blade = TWeakInterfacePtr<ILightsaberBlade>(*Blade);
+	Hit.Victim = Victim;
+	Hit.VictimId = Victim->GetUniqueID();
+	Hit.AttackerId = Attacker->GetUniqueID();
+	Hit.LightsaberId = Hit.Blade.GetObject()->GetUniqueID();
+
+	return true;
+}
+
+void ULightsaberDamageSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SWFL_ResolveHits);
+
+	PendingHits.Sort([](const FPendingHit& A, const FPendingHit& B)
+	{
+		if (A.VictimId != B.VictimId)
+		{
+			return A.VictimId < B.VictimId;
+		}
+
+		if (A.AttackerId != B.AttackerId)
+		{
+			return A.AttackerId < B.AttackerId;
+		}
+
+		return A.LightsaberId < B.LightsaberId;
+	});
+
+	uint32 LastVictimId = 0;
+
+	for (const FPendingHit& Hit : PendingHits)
+	{
+		// Hits are grouped by victim, only the first one of each group plays
+		if (Hit.VictimId == LastVictimId)
+		{
+			continue;
+		}
+
+		ILightsaberBlade* Blade = Hit.Blade.Get();
+		AMainCharacter* Victim = Hit.Victim.Get();
+
+		if (Blade == nullptr || Victim == nullptr)
+		{
+			continue;
+		}
+
+		Blade->DoDamage(Victim);
+
+		INC_DWORD_STAT(STAT_SWFL_HitsResolved);
+		LastVictimId = Hit.VictimId;
+	}
+
+	PendingHits.Reset();
+
+	// Forget the swings of attackers which are gone
+	for (auto It = SwingHits.CreateIterator(); It; ++It)
+	{
+		if (!It.Key().IsValid())
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
+
+bool ULightsaberDamageSubsystem::IsTickable() const
+{
+	return PendingHits.Num() > 0;
+}
+
+ETickableTickType ULightsaberDamageSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+UWorld* ULightsaberDamageSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+TStatId ULightsaberDamageSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(ULightsaberDamageSubsystem, STATGROUP_Tickables);
+}
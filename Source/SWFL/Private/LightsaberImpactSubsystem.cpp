@@ -0,0 +1,163 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LightsaberImpactSubsystem.h"
+#include "Engine/World.h"
+#include "Kismet/GameplayStatics.h"
+#include "Particles/ParticleSystemComponent.h"
+#include "SWFLStats.h"
+
+void ULightsaberImpactSubsystem::AddImpact(const AActor* Source, UParticleSystem* VFX, const FVector& Location, const FRotator& Rotation, const FVector& Scale)
+{
+	UWorld* World = GetWorld();
+
+	if (World == nullptr || Source == nullptr || VFX == nullptr)
+	{
+		return;
+	}
+
+	// Budget of new emitters starts over every frame
+	if (BudgetFrame != GFrameCounter)
+	{
+		BudgetFrame = GFrameCounter;
+		NewEmittersThisFrame = 0;
+	}
+
+	const float Now = World->GetTimeSeconds();
+
+	// Sparks and clashes of one saber are separate streams, a clash while grinding a wall is not rate-limited by the sparks
+	FImpactStream* Stream = Streams.FindByPredicate([Source, VFX](const FImpactStream& Other) { return Other.Source == Source && Other.VFX == VFX; });
+
+	// Impact continues the current contact, move its effect instead of spawning a new one
+	if (Stream && Stream->Component.IsValid()
+		&& (Now - Stream->LastImpactTime) <= MergeTime
+		&& FVector::DistSquared(Location, Stream->LastLocation) <= FMath::Square(MergeDistance))
+	{
+		UParticleSystemComponent* Component = Stream->Component.Get();
+		Component->SetWorldLocationAndRotation(Location, Rotation);
+
+		// Restart the sparks once the previous burst is over
+		if (!Component->IsActive() && (Now - Stream->LastTriggerTime) >= MinImpactInterval)
+		{
+			Component->Activate(true);
+			Stream->LastTriggerTime = Now;
+		}
+
+		Stream->LastLocation = Location;
+		Stream->LastImpactTime = Now;
+
+		NumMerged++;
+		return;
+	}
+
+	// Contact jumped somewhere else too soon after the last effect of this source
+	if (Stream && (Now - Stream->LastTriggerTime) < MinImpactInterval)
+	{
+		NumDropped++;
+		return;
+	}
+
+	if (NewEmittersThisFrame >= MaxNewEmittersPerFrame)
+	{
+		NumDropped++;
+		return;
+	}
+
+	UParticleSystemComponent* Component = UGameplayStatics::SpawnEmitterAtLocation(
+		World,
+		VFX,
+		Location,
+		Rotation,
+		Scale,
+		false,
+		EPSCPoolMethod::ManualRelease,
+		true
+	);
+
+	if (Component == nullptr)
+	{
+		return;
+	}
+
+	NewEmittersThisFrame++;
+	NumSpawned++;
+	SWFL_COUNT_FX_SPAWNED();
+
+	if (Stream)
+	{
+		ReleaseStream(*Stream);
+	}
+	else
+	{
+		Stream = &Streams.AddDefaulted_GetRef();
+		Stream->Source = Source;
+	}
+
+	Stream->Component = Component;
+	Stream->VFX = VFX;
+	Stream->LastLocation = Location;
+	Stream->LastImpactTime = Now;
+	Stream->LastTriggerTime = Now;
+}
+
+void ULightsaberImpactSubsystem::Deinitialize()
+{
+	for (FImpactStream& Stream : Streams)
+	{
+		ReleaseStream(Stream);
+	}
+
+	Streams.Reset();
+
+	Super::Deinitialize();
+}
+
+void ULightsaberImpactSubsystem::Tick(float DeltaTime)
+{
+	const float Now = GetWorld()->GetTimeSeconds();
+
+	for (int32 Index = Streams.Num() - 1; Index >= 0; --Index)
+	{
+		FImpactStream& Stream = Streams[Index];
+
+		if (!Stream.Source.IsValid() || (Now - Stream.LastImpactTime) > MergeTime)
+		{
+			ReleaseStream(Stream);
+			Streams.RemoveAtSwap(Index);
+		}
+	}
+}
+
+bool ULightsaberImpactSubsystem::IsTickable() const
+{
+	return Streams.Num() > 0;
+}
+
+ETickableTickType ULightsaberImpactSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+UWorld* ULightsaberImpactSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+TStatId ULightsaberImpactSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(ULightsaberImpactSubsystem, STATGROUP_Tickables);
+}
+
+void ULightsaberImpactSubsystem::ReleaseStream(FImpactStream& Stream)
+{
+	UParticleSystemComponent* Component = Stream.Component.Get();
+
+	if (Component)
+	{
+		// Let the last sparks finish, the component goes back to the pool once complete
+		Component->Deactivate();
+		Component->ReleaseToPool();
+	}
+
+	Stream.Component.Reset();
+}
@@ -0,0 +1,140 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LightsaberLightBudgetSubsystem.h"
+#include "Engine/World.h"
+#include "Kismet/GameplayStatics.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Components/PointLightComponent.h"
+#include "Lightsaber.h"
+
+void ULightsaberLightBudgetSubsystem::RegisterLightsaber(ALightsaber* Lightsaber)
+{
+	if (Lightsaber)
+	{
+		Lightsabers.AddUnique(Lightsaber);
+
+		// Rank the newcomer on the next tick rather than up to an interval later
+		TimeSinceUpdate = UpdateInterval;
+	}
+}
+
+void ULightsaberLightBudgetSubsystem::UnregisterLightsaber(ALightsaber* Lightsaber)
+{
+	Lightsabers.RemoveSwap(Lightsaber);
+}
+
+void ULightsaberLightBudgetSubsystem::Tick(float DeltaTime)
+{
+	TimeSinceUpdate += DeltaTime;
+
+	if (TimeSinceUpdate < UpdateInterval)
+	{
+		return;
+	}
+
+	TimeSinceUpdate = 0.f;
+
+	// Lights are ranked from the first local player's point of view, without one every light keeps its tier
+	APlayerCameraManager* CameraManager = UGameplayStatics::GetPlayerCameraManager(GetWorld(), 0);
+
+	if (CameraManager == nullptr)
+	{
+		return;
+	}
+
+	const FVector ViewLocation = CameraManager->GetCameraLocation();
+	const FVector ViewDirection = CameraManager->GetCameraRotation().Vector();
+	const float ScreenScale = 1.f / FMath::Max(FMath::Tan(FMath::DegreesToRadians(CameraManager->GetFOVAngle() * 0.5f)), KINDA_SMALL_NUMBER);
+
+	RankedLights.Reset();
+
+	for (int32 Index = Lightsabers.Num() - 1; Index >= 0; --Index)
+	{
+		ALightsaber* Lightsaber = Lightsabers[Index].Get();
+
+		if (Lightsaber == nullptr)
+		{
+			Lightsabers.RemoveAtSwap(Index);
+			continue;
+		}
+
+		// Sheathed sabers have no light to rank
+		if (!Lightsaber->IsBladeVisible())
+		{
+			continue;
+		}
+
+		const UPointLightComponent* Light = Lightsaber->GetLight();
+		const FVector ToLight = Light->GetComponentLocation() - ViewLocation;
+		const float Distance = FMath::Max(ToLight.Size(), 1.f);
+
+		// Projected size of the light's radius on screen
+		float Score = Light->AttenuationRadius / Distance * ScreenScale;
+
+		if (FVector::DotProduct(ToLight, ViewDirection) < -Light->AttenuationRadius)
+		{
+			Score *= BehindCameraFactor;
+		}
+
+		const APawn* OwnerPawn = Cast<APawn>(Lightsaber->GetOwner());
+
+		if (OwnerPawn && OwnerPawn->IsLocallyControlled() && OwnerPawn->IsPlayerControlled())
+		{
+			Score *= LocalPlayerImportance;
+		}
+
+		// Favour the tier the light already has
+		switch (Lightsaber->GetLightTier())
+		{
+		case ELightsaberLightTier::ELT_FULL:
+			Score *= 1.f + 2.f * Hysteresis;
+			break;
+		case ELightsaberLightTier::ELT_UNSHADOWED:
+			Score *= 1.f + Hysteresis;
+			break;
+		default:
+			break;
+		}
+
+		RankedLights.Add({ Lightsaber, Score });
+	}
+
+	RankedLights.Sort([](const FRankedLight& A, const FRankedLight& B) { return A.Score > B.Score; });
+
+	for (int32 Rank = 0; Rank < RankedLights.Num(); ++Rank)
+	{
+		ELightsaberLightTier Tier = ELightsaberLightTier::ELT_OFF;
+
+		if (Rank < MaxFullLights)
+		{
+			Tier = ELightsaberLightTier::ELT_FULL;
+		}
+		else if (Rank < MaxFullLights + MaxUnshadowedLights)
+		{
+			Tier = ELightsaberLightTier::ELT_UNSHADOWED;
+		}
+
+		RankedLights[Rank].Lightsaber->SetLightTier(Tier);
+	}
+}
+
+bool ULightsaberLightBudgetSubsystem::IsTickable() const
+{
+	return Lightsabers.Num() > 0;
+}
+
+ETickableTickType ULightsaberLightBudgetSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+UWorld* ULightsaberLightBudgetSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+TStatId ULightsaberLightBudgetSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(ULightsaberLightBudgetSubsystem, STATGROUP_Tickables);
+}
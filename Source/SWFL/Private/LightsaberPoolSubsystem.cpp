@@ -0,0 +1,170 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LightsaberPoolSubsystem.h"
+#include "Engine/World.h"
+#include "Engine/NetDriver.h"
+#include "GameFramework/GameModeBase.h"
+#include "Lightsaber.h"
+#include "MainCharacter.h"
+#include "SWFLReplicationGraph.h"
+
+void ULightsaberPoolSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	if (InWorld.GetNetMode() == NM_Client)
+	{
+		return;
+	}
+
+	if (PrewarmedLightsabers.Num() == 0)
+	{
+		PrewarmDefaultPawn(InWorld);
+		return;
+	}
+
+	for (const FLightsaberPoolPrewarm& Entry : PrewarmedLightsabers)
+	{
+		Prewarm(Entry.Class.LoadSynchronous(), Entry.Count);
+	}
+}
+
+void ULightsaberPoolSubsystem::PrewarmDefaultPawn(UWorld& InWorld)
+{
+	const AGameModeBase* GameMode = InWorld.GetAuthGameMode();
+	UClass* PawnClass = GameMode ? GameMode->DefaultPawnClass.Get() : nullptr;
+
+	if (PawnClass == nullptr || !PawnClass->IsChildOf(AMainCharacter::StaticClass()))
+	{
+		return;
+	}
+
+	const AMainCharacter* DefaultPawn = GetDefault<AMainCharacter>(PawnClass);
+	const TSubclassOf<ALightsaber> ClassL = DefaultPawn->GetLightsaberClassL();
+	const TSubclassOf<ALightsaber> ClassR = DefaultPawn->GetLightsaberClassR();
+
+	// Both hands may hold the same saber, its pool then serves twice the characters
+	if (ClassL == ClassR)
+	{
+		Prewarm(ClassL, DefaultPawnPrewarmCount * 2);
+	}
+	else
+	{
+		Prewarm(ClassL, DefaultPawnPrewarmCount);
+		Prewarm(ClassR, DefaultPawnPrewarmCount);
+	}
+}
+
+void ULightsaberPoolSubsystem::Deinitialize()
+{
+	// Pooled sabers are actors of the world, they go away with it
+	FreeLightsabers.Reset();
+
+	Super::Deinitialize();
+}
+
+void ULightsaberPoolSubsystem::Prewarm(TSubclassOf<ALightsaber> Class, int32 Count)
+{
+	if (Class == nullptr)
+	{
+		return;
+	}
+
+	TArray<ALightsaber*>& Pool = FreeLightsabers.FindOrAdd(Class).Lightsabers;
+	const int32 Target = FMath::Min(Count, MaxPooledPerClass);
+
+	while (Pool.Num() < Target)
+	{
+		ALightsaber* Lightsaber = SpawnLightsaber(Class, nullptr);
+
+		if (Lightsaber == nullptr)
+		{
+			return;
+		}
+
+		Lightsaber->ReturnToPool();
+		Pool.Add(Lightsaber);
+	}
+}
+
+ALightsaber* ULightsaberPoolSubsystem::AcquireLightsaber(TSubclassOf<ALightsaber> Class, AActor* NewOwner)
+{
+	if (Class == nullptr)
+	{
+		return nullptr;
+	}
+
+	if (FLightsaberPoolList* Pool = FreeLightsabers.Find(Class))
+	{
+		while (Pool->Lightsabers.Num() > 0)
+		{
+			ALightsaber* Lightsaber = Pool->Lightsabers.Pop(false);
+
+			// Destroyed by someone else while it was waiting
+			if (!IsValid(Lightsaber))
+			{
+				continue;
+			}
+
+			Lightsaber->LeavePool(NewOwner);
+			UpdateDependentOwner(Lightsaber, nullptr, NewOwner);
+
+			NumReused++;
+			return Lightsaber;
+		}
+	}
+
+	return SpawnLightsaber(Class, NewOwner);
+}
+
+void ULightsaberPoolSubsystem::ReleaseLightsaber(ALightsaber* Lightsaber)
+{
+	if (!IsValid(Lightsaber) || Lightsaber->IsPooled())
+	{
+		return;
+	}
+
+	TArray<ALightsaber*>& Pool = FreeLightsabers.FindOrAdd(Lightsaber->GetClass()).Lightsabers;
+
+	if (Pool.Num() >= MaxPooledPerClass)
+	{
+		Lightsaber->Destroy();
+		return;
+	}
+
+	AActor* OldOwner = Lightsaber->GetOwner();
+
+	Lightsaber->ReturnToPool();
+	UpdateDependentOwner(Lightsaber, OldOwner, nullptr);
+
+	Pool.Add(Lightsaber);
+}
+
+ALightsaber* ULightsaberPoolSubsystem::SpawnLightsaber(TSubclassOf<ALightsaber> Class, AActor* NewOwner)
+{
+	// Owned from the start, the replication graph makes sabers dependents of their owner when they are spawned
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	SpawnParams.Owner = NewOwner;
+
+	ALightsaber* Lightsaber = GetWorld()->SpawnActor<ALightsaber>(Class, FVector::ZeroVector, FRotator::ZeroRotator, SpawnParams);
+
+	if (Lightsaber)
+	{
+		NumSpawned++;
+	}
+
+	return Lightsaber;
+}
+
+void ULightsaberPoolSubsystem::UpdateDependentOwner(ALightsaber* Lightsaber, AActor* OldOwner, AActor* NewOwner)
+{
+	UNetDriver* NetDriver = GetWorld()->GetNetDriver();
+	USWFLReplicationGraph* ReplicationGraph = NetDriver ? NetDriver->GetReplicationDriver<USWFLReplicationGraph>() : nullptr;
+
+	if (ReplicationGraph)
+	{
+		ReplicationGraph->SetDependentOwner(Lightsaber, OldOwner, NewOwner);
+	}
+}
@@ -0,0 +1,161 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LightsaberSimulationSubsystem.h"
+#include "Engine/World.h"
+#include "Engine/Level.h"
+#include "Async/ParallelFor.h"
+#include "Lightsaber.h"
+#include "SWFLStats.h"
+
+void FLightsaberSimulationTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (Simulation && TickType != LEVELTICK_ViewportsOnly)
+	{
+		Simulation->Simulate(DeltaTime);
+	}
+}
+
+FString FLightsaberSimulationTickFunction::DiagnosticMessage()
+{
+	return TEXT("FLightsaberSimulationTickFunction");
+}
+
+void ULightsaberSimulationSubsystem::Deinitialize()
+{
+	if (SimulationTick.IsTickFunctionRegistered())
+	{
+		SimulationTick.UnRegisterTickFunction();
+	}
+
+	Blades.Reset();
+
+	Super::Deinitialize();
+}
+
+void ULightsaberSimulationSubsystem::WakeLightsaber(ILightsaberBlade* Blade)
+{
+	if (Blade == nullptr)
+	{
+		return;
+	}
+
+	int32 Index = Blade->SimulationIndex;
+
+	if (Index == INDEX_NONE)
+	{
+		Index = AddSlot();
+		Blades[Index] = Blade;
+		Blade->SimulationIndex = Index;
+	}
+
+	ScaleTargets[Index] = Blade->GetBladeScaleTarget();
+	InterpSpeeds[Index] = Blade->GetBladeInterpSpeed();
+	BladeScales[Index] = Blade->GetBladeScale();
+	DefaultLightIntensities[Index] = Blade->GetDefaultLightIntensity();
+}
+
+int32 ULightsaberSimulationSubsystem::AddSlot()
+{
+	const int32 Index = Blades.Add(nullptr);
+	ScaleTargets.AddUninitialized();
+	InterpSpeeds.AddUninitialized();
+	BladeScales.AddUninitialized();
+	DefaultLightIntensities.AddUninitialized();
+	LightIntensities.AddUninitialized();
+	VisibleFlags.AddUninitialized();
+
+	// Tick function is registered with the first saber and only enabled while one is awake
+	if (!SimulationTick.IsTickFunctionRegistered())
+	{
+		SimulationTick.Simulation = this;
+		SimulationTick.TickGroup = TG_PostPhysics;
+		SimulationTick.bCanEverTick = true;
+		SimulationTick.bStartWithTickEnabled = false;
+		SimulationTick.RegisterTickFunction(GetWorld()->PersistentLevel);
+	}
+
+	SimulationTick.SetTickFunctionEnable(true);
+
+	return Index;
+}
+
+void ULightsaberSimulationSubsystem::SleepLightsaber(ILightsaberBlade* Blade)
+{
+	if (Blade && Blades.IsValidIndex(Blade->SimulationIndex) && Blades[Blade->SimulationIndex] == Blade)
+	{
+		RemoveAt(Blade->SimulationIndex);
+	}
+}
+
+void ULightsaberSimulationSubsystem::Simulate(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SWFL_Simulate);
+
+	const int32 Num = Blades.Num();
+	const int32 ClampedBatchSize = FMath::Max(BatchSize, 1);
+	const int32 NumBatches = FMath::DivideAndRoundUp(Num, ClampedBatchSize);
+
+	// Interpolate every blade at once, the kernel only touches the arrays
+	ParallelFor(NumBatches, [this, DeltaTime, Num, ClampedBatchSize](int32 Batch)
+	{
+		const int32 First = Batch * ClampedBatchSize;
+		const int32 Last = FMath::Min(First + ClampedBatchSize, Num);
+
+		for (int32 Index = First; Index < Last; ++Index)
+		{
+			bool bVisible;
+
+			BladeScales[Index] = ALightsaber::StepBladeScale(BladeScales[Index], ScaleTargets[Index], DeltaTime, InterpSpeeds[Index], DefaultLightIntensities[Index], LightIntensities[Index], bVisible);
+			VisibleFlags[Index] = bVisible;
+		}
+	}, NumBatches < 2);
+
+	// Write the results back to the sabers on the game thread
+	for (int32 Index = 0; Index < Blades.Num();)
+	{
+		ILightsaberBlade* Blade = Blades[Index];
+
+		Blade->ApplyBladeStep(BladeScales[Index], VisibleFlags[Index] != 0, LightIntensities[Index]);
+
+		// Once the blade has settled, sleep until the next ignition
+		if (Blade->IsBladeSettled())
+		{
+			RemoveAt(Index);
+			continue;
+		}
+
+		// The blade may have been clamped by a collision, which also changes its speed
+		BladeScales[Index] = Blade->GetBladeScale();
+		InterpSpeeds[Index] = Blade->GetBladeInterpSpeed();
+
+		++Index;
+	}
+
+	SET_DWORD_STAT(STAT_SWFL_SabersTicking, Blades.Num());
+	CSV_CUSTOM_STAT(SWFL, SabersTicking, Blades.Num(), ECsvCustomStatOp::Set);
+
+	if (Blades.Num() == 0)
+	{
+		SimulationTick.SetTickFunctionEnable(false);
+	}
+}
+
+void ULightsaberSimulationSubsystem::RemoveAt(int32 Index)
+{
+	Blades[Index]->SimulationIndex = INDEX_NONE;
+
+	Blades.RemoveAtSwap(Index, 1, false);
+	ScaleTargets.RemoveAtSwap(Index, 1, false);
+	InterpSpeeds.RemoveAtSwap(Index, 1, false);
+	BladeScales.RemoveAtSwap(Index, 1, false);
+	DefaultLightIntensities.RemoveAtSwap(Index, 1, false);
+	LightIntensities.RemoveAtSwap(Index, 1, false);
+	VisibleFlags.RemoveAtSwap(Index, 1, false);
+
+	// The last blade moved into the freed slot
+	if (Blades.IsValidIndex(Index))
+	{
+		Blades[Index]->SimulationIndex = Index;
+	}
+}
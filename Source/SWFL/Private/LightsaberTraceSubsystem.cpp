@@ -0,0 +1,101 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LightsaberTraceSubsystem.h"
+#include "Engine/World.h"
+#include "SWFLStats.h"
+
+void ULightsaberTraceSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	BladeTraceDelegate.BindUObject(this, &ULightsaberTraceSubsystem::OnBladeTraceDone);
+}
+
+void ULightsaberTraceSubsystem::RequestBladeTrace(ILightsaberBlade* Blade, const FVector& StartPoint, const FVector& EndPoint, const FCollisionQueryParams& CollisionParams)
+{
+	if (Blade == nullptr)
+	{
+		return;
+	}
+
+	FBladeTraceRequest& Request = PendingRequests.AddDefaulted_GetRef();
+	Request.Blade = TWeakInterfacePtr<ILightsaberBlade>(*Blade);
+	Request.StartPoint = StartPoint;
+	Request.EndPoint = EndPoint;
+	Request.CollisionParams = CollisionParams;
+}
+
+void ULightsaberTraceSubsystem::Tick(float DeltaTime)
+{
+	UWorld* World = GetWorld();
+
+	if (World == nullptr)
+	{
+		PendingRequests.Reset();
+		return;
+	}
+
+	// Results of the previous batch were delivered before actors ticked, so its slots can be reused
+	InFlightBlades.Reset(PendingRequests.Num());
+
+	for (const FBladeTraceRequest& Request : PendingRequests)
+	{
+		const uint32 UserData = InFlightBlades.Add(Request.Blade);
+
+		World->AsyncLineTraceByChannel(
+			EAsyncTraceType::Single,
+			Request.StartPoint,
+			Request.EndPoint,
+			ECC_Visibility,
+			Request.CollisionParams,
+			FCollisionResponseParams::DefaultResponseParam,
+			&BladeTraceDelegate,
+			UserData
+		);
+	}
+
+	SWFL_COUNT_BLADE_TRACES(PendingRequests.Num());
+
+	PendingRequests.Reset();
+}
+
+bool ULightsaberTraceSubsystem::IsTickable() const
+{
+	return PendingRequests.Num() > 0;
+}
+
+ETickableTickType ULightsaberTraceSubsystem::GetTickableTickType() const
+{
+	// The class default object never has a world to trace in
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+UWorld* ULightsaberTraceSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+TStatId ULightsaberTraceSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(ULightsaberTraceSubsystem, STATGROUP_Tickables);
+}
+
+void ULightsaberTraceSubsystem::OnBladeTraceDone(const FTraceHandle& TraceHandle, FTraceDatum& TraceData)
+{
+	if (!InFlightBlades.IsValidIndex(TraceData.UserData))
+	{
+		return;
+	}
+
+	ILightsaberBlade* Blade = InFlightBlades[TraceData.UserData].Get();
+
+	if (Blade == nullptr)
+	{
+		return;
+	}
+
+	const bool bIsHit = TraceData.OutHits.Num() > 0 && TraceData.OutHits[0].bBlockingHit;
+
+	Blade->ReceiveBladeTrace(bIsHit, bIsHit ? TraceData.OutHits[0] : FHitResult());
+}
@@ -12,9 +12,31 @@
 #include "Particles/ParticleSystemComponent.h"
 #include "DrawDebugHelpers.h"
 #include "Kismet/GameplayStatics.h"
+#include "Engine/World.h"
+#include "Physics/PhysicsInterfaceCore.h"
+#include "PhysicsEngine/BodyInstance.h"
+#include "SWFLStats.h"
+#include "Net/UnrealNetwork.h"
+#include "GameFramework/GameStateBase.h"
+#include "CombatLagCompensationSubsystem.h"
+#include "LightsaberDamageSubsystem.h"
+#include "LightsaberAudioSubsystem.h"
+#include "Sound/SoundCue.h"
+#include "SWFLCharacterMovementComponent.h"
+#include "LightsaberPoolSubsystem.h"
+#include "LightsaberComponent.h"
+
+#if !(UE_BUILD_SHIPPING || UE_BUILD_TEST)
+static TAutoConsoleVariable<int32> CVarDebugForcePush(
+	TEXT("swfl.Debug.ForcePush"),
+	0,
+	TEXT("Draw the force push cone and log the bodies it hits. Off by default, so benchmarks and soak runs stay clean."),
+	ECVF_Cheat);
+#endif
 
 // Sets default values
-AMainCharacter::AMainCharacter()
+AMainCharacter::AMainCharacter(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer.SetDefaultSubobjectClass<USWFLCharacterMovementComponent>(ACharacter::CharacterMovementComponentName))
 {
  	// Set this character to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
 	PrimaryActorTick.bCanEverTick = true;
@@ -53,13 +75,17 @@ AMainCharacter::AMainCharacter()
 	GetCharacterMovement()->bAllowPhysicsRotationDuringAnimRootMotion = true;
 
 	bIsWalking = true;
-	bShouldJog = false;
 	bIsEvading = false;
 	bIsDoubleStepping = false;
 	bIsSprinting = false;
 
 	SocketSpawnLeft = "lightsaber_l";
 	SocketSpawnRight = "lightsaber_r";
+
+	LightsaberMode = ELightsaberMode::ELM_ACTOR;
+	LightsaberComponentClass = ULightsaberComponent::StaticClass();
+	LightsaberComponent_l = nullptr;
+	LightsaberComponent_r = nullptr;
 }
 
 // Called when the game starts or when spawned
@@ -71,29 +97,321 @@ void AMainCharacter::BeginPlay()
 	GetMesh()->SetCollisionResponseToChannel(ECollisionChannel::ECC_Camera, ECollisionResponse::ECR_Ignore);
 	GetCapsuleComponent()->SetCollisionResponseToChannel(ECollisionChannel::ECC_Camera, ECollisionResponse::ECR_Ignore);
 	
-	FActorSpawnParameters SpawnParams;
-	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	// Sabers replicate, clients get the server's ones
+	if (!HasAuthority())
+	{
+		return;
+	}
 
-	Lightsaber_l = GetWorld()->SpawnActor<ALightsaber>(Lightsaber_1, FVector::ZeroVector, FRotator::ZeroRotator, SpawnParams);
+	// The server keeps a history of this character's poses to validate hits claimed by clients
+	if (UCombatLagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<UCombatLagCompensationSubsystem>())
+	{
+		LagCompensation->RegisterCharacter(this);
+	}
+
+	if (LightsaberMode == ELightsaberMode::ELM_COMPONENT)
+	{
+		LightsaberComponent_l = CreateLightsaberComponent(SocketSpawnLeft);
+		LightsaberComponent_r = CreateLightsaberComponent(SocketSpawnRight);
+		return;
+	}
+
+	Lightsaber_l = AcquireLightsaber(Lightsaber_1);
 	if (Lightsaber_l)
 	{
-		Lightsaber_l->SetOwner(this);
-		Lightsaber_l->AttachToComponent(GetMesh(), FAttachmentTransformRules::SnapToTargetNotIncludingScale, SocketSpawnLeft);
+		Lightsaber_l->AttachToMesh(GetMesh(), SocketSpawnLeft);
+	}
+
+	Lightsaber_r = AcquireLightsaber(Lightsaber_2);
+	if (Lightsaber_r)
+	{
+		Lightsaber_r->AttachToMesh(GetMesh(), SocketSpawnRight);
+	}
+}
+
+void AMainCharacter::SetLightsaberMode(ELightsaberMode NewMode)
+{
+	if (!HasAuthority() || NewMode == LightsaberMode || NewMode == ELightsaberMode::ELM_MAX)
+	{
+		return;
+	}
+
+	const bool bWasIgnited = AreLightsabersIgnited();
+
+	LightsaberMode = NewMode;
+
+	// Sabers are created at begin play, until then only the mode changes
+	if (!HasActorBegunPlay())
+	{
+		return;
+	}
+
+	if (NewMode == ELightsaberMode::ELM_COMPONENT)
+	{
+		// Back to the pool, another hero picks them up without building them again
+		ReleaseLightsaber(Lightsaber_l, EEndPlayReason::Destroyed);
+		Lightsaber_l = nullptr;
+
+		ReleaseLightsaber(Lightsaber_r, EEndPlayReason::Destroyed);
+		Lightsaber_r = nullptr;
+
+		LightsaberComponent_l = CreateLightsaberComponent(SocketSpawnLeft);
+		LightsaberComponent_r = CreateLightsaberComponent(SocketSpawnRight);
+	}
+	else
+	{
+		DestroyLightsaberComponents();
+
+		Lightsaber_l = AcquireLightsaber(Lightsaber_1);
+		if (Lightsaber_l)
+		{
+			Lightsaber_l->AttachToMesh(GetMesh(), SocketSpawnLeft);
+		}
+
+		Lightsaber_r = AcquireLightsaber(Lightsaber_2);
+		if (Lightsaber_r)
+		{
+			Lightsaber_r->AttachToMesh(GetMesh(), SocketSpawnRight);
+		}
+	}
+
+	if (bWasIgnited)
+	{
+		SetLightsabersIgnited(true);
+	}
+}
+
+ULightsaberComponent* AMainCharacter::CreateLightsaberComponent(FName SocketName)
+{
+	if (LightsaberComponentClass == nullptr)
+	{
+		return nullptr;
+	}
+
+	ULightsaberComponent* Lightsaber = NewObject<ULightsaberComponent>(this, LightsaberComponentClass);
+	Lightsaber->SetupAttachment(GetMesh(), SocketName);
+	Lightsaber->SetIsReplicated(true);
+	Lightsaber->RegisterComponent();
+
+	return Lightsaber;
+}
+
+void AMainCharacter::DestroyLightsaberComponents()
+{
+	if (LightsaberComponent_l)
+	{
+		LightsaberComponent_l->DestroyComponent();
+		LightsaberComponent_l = nullptr;
+	}
+
+	if (LightsaberComponent_r)
+	{
+		LightsaberComponent_r->DestroyComponent();
+		LightsaberComponent_r = nullptr;
+	}
+}
+
+bool AMainCharacter::HasLightsabers() const
+{
+	return GetBlade(0) && GetBlade(1);
+}
+
+ILightsaberBlade* AMainCharacter::GetBlade(int32 Side) const
+{
+	if (Side != 0 && Side != 1)
+	{
+		return nullptr;
+	}
+
+	// Only one of them is set at a time, clients may get the new sabers before the mode
+	if (ALightsaber* Lightsaber = Side == 0 ? Lightsaber_l : Lightsaber_r)
+	{
+		return Lightsaber;
+	}
+
+	return Side == 0 ? LightsaberComponent_l : LightsaberComponent_r;
+}
+
+int32 AMainCharacter::GetBladeSide(const ILightsaberBlade* Blade) const
+{
+	if (Blade == nullptr)
+	{
+		return INDEX_NONE;
 	}
 
-	Lightsaber_r = GetWorld()->SpawnActor<ALightsaber>(Lightsaber_2, FVector::ZeroVector, FRotator::ZeroRotator, SpawnParams);
+	if (Blade == GetBlade(0))
+	{
+		return 0;
+	}
+
+	return Blade == GetBlade(1) ? 1 : INDEX_NONE;
+}
+
+bool AMainCharacter::AreLightsabersIgnited() const
+{
+	const ILightsaberBlade* BladeL = GetBlade(0);
+	const ILightsaberBlade* BladeR = GetBlade(1);
+
+	return (BladeL && BladeL->GetIsIgnited()) || (BladeR && BladeR->GetIsIgnited());
+}
+
+void AMainCharacter::SetLightsabersIgnited(bool bIgnited)
+{
+	for (int32 Side = 0; Side < 2; ++Side)
+	{
+		if (ILightsaberBlade* Blade = GetBlade(Side))
+		{
+			if (bIgnited)
+			{
+				Blade->IgniteLightsaber();
+			}
+			else
+			{
+				Blade->ExtinguishLightsaber();
+			}
+		}
+	}
+}
+
+void AMainCharacter::SetTrailsVisible(bool bVisible)
+{
+	// Blade components have no trail
+	if (Lightsaber_l)
+	{
+		Lightsaber_l->GetTrail()->SetVisibility(bVisible);
+	}
 	if (Lightsaber_r)
 	{
-		Lightsaber_r->SetOwner(this);
-		Lightsaber_r->AttachToComponent(GetMesh(), FAttachmentTransformRules::SnapToTargetNotIncludingScale, SocketSpawnRight);
+		Lightsaber_r->GetTrail()->SetVisibility(bVisible);
 	}
 }
 
+void AMainCharacter::SetBladeCollisionActive(bool bActive)
+{
+	for (int32 Side = 0; Side < 2; ++Side)
+	{
+		if (ILightsaberBlade* Blade = GetBlade(Side))
+		{
+			Blade->SetBladeCollisionActive(bActive);
+		}
+	}
+}
+
+bool AMainCharacter::GetBladeSegment(int32 Side, FVector& OutBase, FVector& OutTip) const
+{
+	const ILightsaberBlade* Blade = GetBlade(Side);
+
+	if (Blade == nullptr || !Blade->IsBladeVisible())
+	{
+		return false;
+	}
+
+	Blade->GetBladeSegment(OutBase, OutTip);
+	return true;
+}
+
+float AMainCharacter::GetBladeRadius(int32 Side) const
+{
+	const ILightsaberBlade* Blade = GetBlade(Side);
+
+	return Blade ? Blade->GetBladeRadius() : 0.f;
+}
+
+ALightsaber* AMainCharacter::AcquireLightsaber(TSubclassOf<ALightsaber> LightsaberClass)
+{
+	// Pooled sabers are already constructed, respawns and waves do not build their components
+	if (ULightsaberPoolSubsystem* Pool = GetWorld()->GetSubsystem<ULightsaberPoolSubsystem>())
+	{
+		return Pool->AcquireLightsaber(LightsaberClass, this);
+	}
+
+	// Owned from the start, the replication graph makes sabers dependents of their owner when they are spawned
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	SpawnParams.Owner = this;
+
+	return GetWorld()->SpawnActor<ALightsaber>(LightsaberClass, FVector::ZeroVector, FRotator::ZeroRotator, SpawnParams);
+}
+
+void AMainCharacter::ReleaseLightsaber(ALightsaber* Lightsaber, EEndPlayReason::Type EndPlayReason)
+{
+	if (Lightsaber == nullptr)
+	{
+		return;
+	}
+
+	ULightsaberPoolSubsystem* Pool = GetWorld()->GetSubsystem<ULightsaberPoolSubsystem>();
+
+	// Sabers of a world going away are not worth keeping
+	if (Pool && (EndPlayReason == EEndPlayReason::Destroyed || EndPlayReason == EEndPlayReason::RemovedFromWorld))
+	{
+		Pool->ReleaseLightsaber(Lightsaber);
+	}
+	else
+	{
+		Lightsaber->Destroy();
+	}
+}
+
+void AMainCharacter::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(AMainCharacter, Lightsaber_l);
+	DOREPLIFETIME(AMainCharacter, Lightsaber_r);
+	DOREPLIFETIME(AMainCharacter, LightsaberMode);
+	DOREPLIFETIME(AMainCharacter, LightsaberComponent_l);
+	DOREPLIFETIME(AMainCharacter, LightsaberComponent_r);
+}
+
+void AMainCharacter::OnRep_Lightsabers()
+{
+	if (Lightsaber_l && Lightsaber_l->GetAttachParentActor() != this)
+	{
+		Lightsaber_l->AttachToMesh(GetMesh(), SocketSpawnLeft);
+	}
+
+	if (Lightsaber_r && Lightsaber_r->GetAttachParentActor() != this)
+	{
+		Lightsaber_r->AttachToMesh(GetMesh(), SocketSpawnRight);
+	}
+}
+
+void AMainCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// Replicated sabers are handed back to the pool by the server
+	if (!HasAuthority())
+	{
+		Super::EndPlay(EndPlayReason);
+		return;
+	}
+
+	if (UCombatLagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<UCombatLagCompensationSubsystem>())
+	{
+		LagCompensation->UnregisterCharacter(this);
+	}
+
+	ReleaseLightsaber(Lightsaber_l, EndPlayReason);
+	Lightsaber_l = nullptr;
+
+	ReleaseLightsaber(Lightsaber_r, EndPlayReason);
+	Lightsaber_r = nullptr;
+
+	DestroyLightsaberComponents();
+
+	Super::EndPlay(EndPlayReason);
+}
+
 // Called every frame
 void AMainCharacter::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
 
+	// Buffered actions go through as soon as the current move lets them
+	if (InputBufferCount > 0)
+	{
+		ConsumeBufferedInput();
+	}
 }
 
 // Called to bind functionality to input
@@ -112,10 +430,10 @@ void AMainCharacter::SetupPlayerInputComponent(UInputComponent* PlayerInputCompo
 	PlayerInputComponent->BindAction("Sprint", IE_Pressed, this, &AMainCharacter::SprintOn);
 	PlayerInputComponent->BindAction("Sprint", IE_Released, this, &AMainCharacter::SprintOff);
 
-	PlayerInputComponent->BindAction("Evade", IE_Pressed, this, &AMainCharacter::Evade);
-	PlayerInputComponent->BindAction("DoubleStep", IE_DoubleClick, this, &AMainCharacter::DoubleStep);
+	PlayerInputComponent->BindAction("Evade", IE_Pressed, this, &AMainCharacter::BufferEvade);
+	PlayerInputComponent->BindAction("DoubleStep", IE_DoubleClick, this, &AMainCharacter::BufferDoubleStep);
 
-	PlayerInputComponent->BindAction("MeleeAttack", IE_Pressed, this, &AMainCharacter::MeleeAttack);
+	PlayerInputComponent->BindAction("MeleeAttack", IE_Pressed, this, &AMainCharacter::BufferMeleeAttack);
 
 	PlayerInputComponent->BindAction("Push", IE_Pressed, this, &AMainCharacter::ForcePush);
 
@@ -133,10 +451,7 @@ void AMainCharacter::MoveForward(float Value)
 	if ((Controller) && (Value != 0.f))
 	{
 		// Find out which way is forward
-		const FRotator Rotation = Controller->GetControlRotation();
-		const FRotator YawRotation(0.f, Rotation.Yaw, 0.f);
-
-		const FVector Direction = FRotationMatrix(YawRotation).GetUnitAxis(EAxis::X);
+		const FVector Direction = GetMovementDirection(Controller->GetControlRotation(), EAxis::X);
 		AddMovementInput(Direction, Value);
 	}
 }
@@ -145,15 +460,19 @@ void AMainCharacter::MoveRight(float Value)
 {
 	if ((Controller) && (Value != 0.f))
 	{
-		// Find out which way is forward
-		const FRotator Rotation = Controller->GetControlRotation();
-		const FRotator YawRotation(0.f, Rotation.Yaw, 0.f);
-
-		const FVector Direction = FRotationMatrix(YawRotation).GetUnitAxis(EAxis::Y);
+		// Find out which way is right
+		const FVector Direction = GetMovementDirection(Controller->GetControlRotation(), EAxis::Y);
 		AddMovementInput(Direction, Value);
 	}
 }
 
+FVector AMainCharacter::GetMovementDirection(const FRotator& ControlRotation, EAxis::Type Axis)
+{
+	const FRotator YawRotation(0.f, ControlRotation.Yaw, 0.f);
+
+	return FRotationMatrix(YawRotation).GetUnitAxis(Axis);
+}
+
 void AMainCharacter::TurnAtRate(float Rate)
 {
 	AddControllerYawInput(Rate * BaseTurnRate * GetWorld()->GetDeltaSeconds());
@@ -166,186 +485,323 @@ void AMainCharacter::LookUpAtRate(float Rate)
 
 void AMainCharacter::DoubleJump()
 {
-	if (GetMesh()->GetAnimInstance())
+	if (DoubleJumpCounter > 1)
 	{
-		UAnimInstance* AnimInstance = this->GetMesh()->GetAnimInstance();
+		return;
+	}
 
-		if (AnimInstance && DoubleJumpCounter <= 1)
-		{
-			switch (DoubleJumpCounter)
-			{
-			case 0:
-				if (Lightsaber_l)
-				{
-					Lightsaber_l->GetTrail()->SetVisibility(true);
-				}
-				if (Lightsaber_r)
-				{
-					Lightsaber_r->GetTrail()->SetVisibility(true);
-				}
-				AMainCharacter::LaunchCharacter(JumpOneHeigth, false, true);
-				DoubleJumpCounter++;
-				if (FirstJump)
-				{
-					AnimInstance->Montage_Play(FirstJump, 1.f);
-				}
-				break;
-			case 1:
-				AMainCharacter::LaunchCharacter(JumpTwoHeigth, false, true);
-				DoubleJumpCounter++;
-				if (SecondJump)
-				{
-					AnimInstance->Montage_Play(SecondJump, 1.f);
-				}
-				break;
-			default:
-				break;
-			}
-		}
+	if (USWFLCharacterMovementComponent* Movement = Cast<USWFLCharacterMovementComponent>(GetCharacterMovement()))
+	{
+		Movement->RequestDoubleJump();
+	}
+	else
+	{
+		PerformDoubleJump(false);
+	}
+}
+
+void AMainCharacter::PerformDoubleJump(bool bReplaying)
+{
+	if (DoubleJumpCounter > 1)
+	{
+		return;
+	}
+
+	const bool bFirstJump = DoubleJumpCounter == 0;
+
+	LaunchCharacter(bFirstJump ? JumpOneHeigth : JumpTwoHeigth, false, true);
+	DoubleJumpCounter++;
+
+	if (bReplaying)
+	{
+		return;
+	}
+
+	if (bFirstJump)
+	{
+		SetTrailsVisible(true);
+	}
+
+	UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance();
+	UAnimMontage* JumpMontage = bFirstJump ? FirstJump : SecondJump;
+
+	if (AnimInstance && JumpMontage)
+	{
+		AnimInstance->Montage_Play(JumpMontage, 1.f);
 	}
 }
 
 void AMainCharacter::Landed(const FHitResult& Hit)
 {
 	DoubleJumpCounter = 0;
-	if (Lightsaber_l)
+	SetTrailsVisible(false);
+}
+
+void AMainCharacter::Evade()
+{
+	if (bIsEvading || GetCharacterMovement()->IsFalling() || EvadeMontage == nullptr)
 	{
-		Lightsaber_l->GetTrail()->SetVisibility(false);
+		return;
 	}
-	if (Lightsaber_r)
+
+	if (USWFLCharacterMovementComponent* Movement = Cast<USWFLCharacterMovementComponent>(GetCharacterMovement()))
 	{
-		Lightsaber_r->GetTrail()->SetVisibility(false);
+		Movement->RequestEvade();
+	}
+	else
+	{
+		PerformEvade(false);
 	}
 }
 
-void AMainCharacter::Evade()
+void AMainCharacter::PerformEvade(bool bReplaying)
 {
-	if (!(bIsEvading))
+	// Root motion of the montage started by the original move is replayed from the saved move
+	if (bReplaying || bIsEvading || GetCharacterMovement()->IsFalling())
 	{
-		if (!(this->GetCharacterMovement()->IsFalling()) && GetMesh()->GetAnimInstance())
-		{
-			UAnimInstance* AnimInstance = this->GetMesh()->GetAnimInstance();
+		return;
+	}
 
-			if (AnimInstance && EvadeMontage)
-			{
-				bIsEvading = true;
+	UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance();
 
-				if (bIsSprinting)
-				{
-					AnimInstance->Montage_Play(EvadeMontage, 1.25f);
-				}
-				else
-				{
-					AnimInstance->Montage_Play(EvadeMontage, 1.f);
-				}
+	if (AnimInstance && EvadeMontage)
+	{
+		bIsEvading = true;
 
-				if (Lightsaber_l)
-				{
-					Lightsaber_l->GetTrail()->SetVisibility(true);
-				}
-				if (Lightsaber_r)
-				{
-					Lightsaber_r->GetTrail()->SetVisibility(true);
-				}
-			}
+		if (bIsSprinting)
+		{
+			AnimInstance->Montage_Play(EvadeMontage, 1.25f);
 		}
+		else
+		{
+			AnimInstance->Montage_Play(EvadeMontage, 1.f);
+		}
+
+		SetTrailsVisible(true);
 	}
 }
 
 void AMainCharacter::DoubleStep()
 {
-	if (!(this->GetCharacterMovement()->IsFalling()) && GetMesh()->GetAnimInstance() && !(bIsDoubleStepping))
+	if (bIsDoubleStepping || GetCharacterMovement()->IsFalling() || DoubleStepMontage == nullptr)
 	{
-		UAnimInstance* AnimInstance = this->GetMesh()->GetAnimInstance();
+		return;
+	}
 
-		if (AnimInstance && DoubleStepMontage)
-		{
-			bIsDoubleStepping = true;
-			AnimInstance->Montage_Play(DoubleStepMontage, 1.f);
+	if (USWFLCharacterMovementComponent* Movement = Cast<USWFLCharacterMovementComponent>(GetCharacterMovement()))
+	{
+		Movement->RequestDoubleStep();
+	}
+	else
+	{
+		PerformDoubleStep(false);
+	}
+}
 
-			if (Lightsaber_l)
-			{
-				Lightsaber_l->GetTrail()->SetVisibility(true);
-			}
-			if (Lightsaber_r)
-			{
-				Lightsaber_r->GetTrail()->SetVisibility(true);
-			}
-		}
+void AMainCharacter::PerformDoubleStep(bool bReplaying)
+{
+	if (bReplaying || bIsDoubleStepping || GetCharacterMovement()->IsFalling())
+	{
+		return;
+	}
+
+	UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance();
+
+	if (AnimInstance && DoubleStepMontage)
+	{
+		bIsDoubleStepping = true;
+		AnimInstance->Montage_Play(DoubleStepMontage, 1.f);
+
+		SetTrailsVisible(true);
 	}
 }
 
 void AMainCharacter::ToggleLightsaber()
 {
-	if (Lightsaber_r && Lightsaber_l)
+	// The server owns saber state, the local toggle is a prediction it replicates back
+	if (GetLocalRole() == ROLE_AutonomousProxy)
+	{
+		ServerToggleLightsaber();
+	}
+
+	if (HasLightsabers())
+	{
+		SetLightsabersIgnited(!AreLightsabersIgnited());
+	}
+}
+
+void AMainCharacter::ServerToggleLightsaber_Implementation()
+{
+	ToggleLightsaber();
+}
+
+void AMainCharacter::ClaimBladeHit(int32 Side, AMainCharacter* Victim)
+{
+	FVector BladeBase;
+	FVector BladeTip;
+
+	if (Victim == nullptr || !GetBladeSegment(Side, BladeBase, BladeTip))
+	{
+		return;
+	}
+
+	// Other characters are seen as they were on the server about one trip ago, which is what this estimate gives
+	const AGameStateBase* GameState = GetWorld()->GetGameState();
+	const float ViewTime = GameState ? GameState->GetServerWorldTimeSeconds() : GetWorld()->GetTimeSeconds();
+
+	ServerClaimBladeHit(static_cast<uint8>(Side), Victim, SwingId, BladeBase, BladeTip, ViewTime);
+}
+
+void AMainCharacter::ServerClaimBladeHit_Implementation(uint8 Side, AMainCharacter* Victim, int32 ClaimedSwingId, FVector_NetQuantize10 BladeBase, FVector_NetQuantize10 BladeTip, float ViewTime)
+{
+	UCombatLagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<UCombatLagCompensationSubsystem>();
+
+	if (Side > 1 || LagCompensation == nullptr || !LagCompensation->ValidateBladeHit(this, Side, Victim, BladeBase, BladeTip, ViewTime))
+	{
+		return;
+	}
+
+	if (!AcceptClaimedSwing(ClaimedSwingId, Victim))
+	{
+		return;
+	}
+
+	QueueBladeHit(GetBlade(Side), ClaimedSwingId, Victim);
+}
+
+void AMainCharacter::HandleBladeHit(int32 Side, AMainCharacter* Victim)
+{
+	if (GetBlade(Side) == nullptr || Victim == nullptr || Victim == this)
 	{
-		if ((Lightsaber_l->GetIsIgnited() == false) && (Lightsaber_r->GetIsIgnited() == false))
+		return;
+	}
+
+	if (IsPlayerControlled())
+	{
+		// Players' swings play on their own machine, the server waits for the client's claim
+		if (!IsLocallyControlled())
 		{
-			Lightsaber_l->IgniteLightsaber();
-			Lightsaber_r->IgniteLightsaber();
+			return;
 		}
-		else
+
+		// The client plays its hit right away and has the server validate it
+		if (!HasAuthority())
 		{
-			Lightsaber_l->ExtinguishLightsaber();
-			Lightsaber_r->ExtinguishLightsaber();
+			ClaimBladeHit(Side, Victim);
 		}
 	}
+
+	QueueBladeHit(GetBlade(Side), SwingId, Victim);
 }
 
-void AMainCharacter::ToggleMovement()
+void AMainCharacter::QueueBladeHit(ILightsaberBlade* Blade, int32 HitSwingId, AMainCharacter* Victim)
 {
-	if (bIsSprinting)
+	if (Blade == nullptr)
 	{
 		return;
 	}
 
-	if (bIsWalking)
+	if (ULightsaberDamageSubsystem* DamageSubsystem = GetWorld()->GetSubsystem<ULightsaberDamageSubsystem>())
 	{
-		bIsWalking = false;
-		GetCharacterMovement()->MaxWalkSpeed = JogSpeed;
+		DamageSubsystem->QueueHit(Blade, this, HitSwingId, Victim);
 	}
 	else
 	{
-		bIsWalking = true;
-		GetCharacterMovement()->MaxWalkSpeed = WalkSpeed;
+		Blade->DoDamage(Victim);
 	}
 }
 
-void AMainCharacter::SprintOn()
+bool AMainCharacter::AcceptClaimedSwing(int32 ClaimedSwingId, AMainCharacter* Victim)
 {
-	bIsSprinting = true;
+	const float Now = GetWorld()->GetTimeSeconds();
+
+	// Swings which hit nothing are never claimed, so ids may skip ahead as far as the client could have swung since
+	if (LastClaimedSwingId != INDEX_NONE)
+	{
+		const int32 MaxSwingsSince = 1 + FMath::FloorToInt((Now - LastClaimedSwingTime) / FMath::Max(MinSwingInterval, KINDA_SMALL_NUMBER));
 
-	if (bIsWalking)
+		if (ClaimedSwingId < LastClaimedSwingId || ClaimedSwingId > LastClaimedSwingId + MaxSwingsSince)
+		{
+			return false;
+		}
+	}
+	else if (ClaimedSwingId < 0)
 	{
-		bIsWalking = true;
-		bShouldJog = false;
-		GetCharacterMovement()->MaxWalkSpeed = SprintSpeed;
+		return false;
 	}
-	else
+
+	// Windows which ran out start again from the next claim
+	VictimClaims.RemoveAllSwap([Now, this](const FVictimClaims& Entry)
+	{
+		return !Entry.Victim.IsValid() || (Now - Entry.WindowStart) >= ClaimWindow;
+	});
+
+	FVictimClaims* Claims = VictimClaims.FindByPredicate([Victim](const FVictimClaims& Entry)
+	{
+		return Entry.Victim.Get() == Victim;
+	});
+
+	if (Claims == nullptr)
+	{
+		Claims = &VictimClaims.AddDefaulted_GetRef();
+		Claims->Victim = Victim;
+		Claims->WindowStart = Now;
+		Claims->NumClaims = 0;
+	}
+	else if (Claims->NumClaims >= MaxClaimsPerVictim)
 	{
-		bIsWalking = false;
-		bShouldJog = true;
-		GetCharacterMovement()->MaxWalkSpeed = SprintSpeed;
+		return false;
 	}
+
+	Claims->NumClaims++;
+
+	if (ClaimedSwingId != LastClaimedSwingId)
+	{
+		LastClaimedSwingId = ClaimedSwingId;
+		LastClaimedSwingTime = Now;
+	}
+
+	return true;
 }
 
-void AMainCharacter::SprintOff()
+void AMainCharacter::ToggleMovement()
 {
-	bIsSprinting = false;
-
-	if (bShouldJog)
+	if (bIsSprinting)
 	{
-		GetCharacterMovement()->MaxWalkSpeed = JogSpeed;
+		return;
 	}
-	else
+
+	SetWalking(!bIsWalking);
+}
+
+void AMainCharacter::SetWalking(bool bWalking)
+{
+	bIsWalking = bWalking;
+
+	// Sprinting keeps its speed, the walk or jog comes back with SprintOff
+	if (!bIsSprinting)
 	{
-		GetCharacterMovement()->MaxWalkSpeed = WalkSpeed;
+		GetCharacterMovement()->MaxWalkSpeed = bIsWalking ? WalkSpeed : JogSpeed;
 	}
 }
 
+void AMainCharacter::SprintOn()
+{
+	bIsSprinting = true;
+	GetCharacterMovement()->MaxWalkSpeed = SprintSpeed;
+}
+
+void AMainCharacter::SprintOff()
+{
+	bIsSprinting = false;
+	GetCharacterMovement()->MaxWalkSpeed = bIsWalking ? WalkSpeed : JogSpeed;
+}
+
 void AMainCharacter::MeleeAttack()
 {
-	if (!(this->GetCharacterMovement()->IsFalling()) && Lightsaber_r && Lightsaber_l && (!bIsEvading) && (!bIsDoubleStepping))
+	SCOPE_CYCLE_COUNTER(STAT_SWFL_MeleeAttack);
+
+	if (!(this->GetCharacterMovement()->IsFalling()) && HasLightsabers() && (!bIsEvading) && (!bIsDoubleStepping))
 	{
 		if (Combo > 3)
 		{
@@ -361,7 +817,7 @@ void AMainCharacter::MeleeAttack()
 		{
 			UAnimInstance* AnimInstance = this->GetMesh()->GetAnimInstance();
 
-			if ((Lightsaber_l->GetIsIgnited() == false) && (Lightsaber_r->GetIsIgnited() == false))
+			if (!AreLightsabersIgnited())
 			{
 				ToggleLightsaber();
 			}
@@ -403,17 +859,134 @@ void AMainCharacter::MeleeAttack()
 				}
 			}
 
-			Lightsaber_l->GetTrail()->SetVisibility(true);
-			Lightsaber_r->GetTrail()->SetVisibility(true);
+			SetTrailsVisible(true);
 		}
 
 		Combo++;
+
+		// Every combo step is a new swing for hit registration
+		SwingId++;
 	}
 }
 
+void AMainCharacter::BufferMeleeAttack()
+{
+	BufferAction(EBufferedAction::EBA_MELEE);
+}
+
+void AMainCharacter::BufferEvade()
+{
+	BufferAction(EBufferedAction::EBA_EVADE);
+}
+
+void AMainCharacter::BufferDoubleStep()
+{
+	BufferAction(EBufferedAction::EBA_DOUBLESTEP);
+}
+
+void AMainCharacter::BufferAction(EBufferedAction Action)
+{
+	// A full buffer forgets its oldest action
+	if (InputBufferCount == InputBufferSize)
+	{
+		InputBufferHead = (InputBufferHead + 1) % InputBufferSize;
+		InputBufferCount--;
+	}
+
+	FBufferedInput& Input = InputBuffer[(InputBufferHead + InputBufferCount) % InputBufferSize];
+	Input.Action = Action;
+	Input.Time = GetWorld()->GetRealTimeSeconds();
+	InputBufferCount++;
+
+	// Free characters act on the same frame
+	ConsumeBufferedInput();
+}
+
+void AMainCharacter::ConsumeBufferedInput()
+{
+	const float Now = GetWorld()->GetRealTimeSeconds();
+
+	while (InputBufferCount > 0)
+	{
+		const FBufferedInput& Input = InputBuffer[InputBufferHead];
+
+		// Actions are performed in the order they were pressed, the oldest one waits for its turn
+		if ((Now - Input.Time) <= InputBufferDuration && !CanPerformAction(Input.Action))
+		{
+			return;
+		}
+
+		const EBufferedAction Action = Input.Action;
+		const bool bExpired = (Now - Input.Time) > InputBufferDuration;
+
+		InputBufferHead = (InputBufferHead + 1) % InputBufferSize;
+		InputBufferCount--;
+
+		if (bExpired)
+		{
+			continue;
+		}
+
+		switch (Action)
+		{
+		case EBufferedAction::EBA_MELEE:
+			// Cancel the current swing into the next one
+			if (bIsCancelWindowOpen)
+			{
+				bIsAttacking = false;
+			}
+			MeleeAttack();
+			break;
+		case EBufferedAction::EBA_EVADE:
+			Evade();
+			break;
+		case EBufferedAction::EBA_DOUBLESTEP:
+			DoubleStep();
+			break;
+		default:
+			break;
+		}
+
+		// The window is spent on the action it let through
+		bIsCancelWindowOpen = false;
+
+		return;
+	}
+}
+
+bool AMainCharacter::CanPerformAction(EBufferedAction Action) const
+{
+	const bool bIsFalling = GetCharacterMovement()->IsFalling();
+
+	switch (Action)
+	{
+	case EBufferedAction::EBA_MELEE:
+		return !bIsFalling && HasLightsabers() && !bIsEvading && !bIsDoubleStepping && (!bIsAttacking || bIsCancelWindowOpen);
+	case EBufferedAction::EBA_EVADE:
+		return !bIsFalling && !bIsEvading;
+	case EBufferedAction::EBA_DOUBLESTEP:
+		return !bIsFalling && !bIsDoubleStepping;
+	default:
+		return false;
+	}
+}
+
+void AMainCharacter::OpenCancelWindow()
+{
+	bIsCancelWindowOpen = true;
+
+	// Anything waiting goes through right away
+	ConsumeBufferedInput();
+}
+
+void AMainCharacter::CloseCancelWindow()
+{
+	bIsCancelWindowOpen = false;
+}
+
 void AMainCharacter::ForcePush()
 {
-	FHitResult OutHit;
+	SCOPE_CYCLE_COUNTER(STAT_SWFL_ForcePush);
 
 	// Start point
 	FVector StartPoint = GetActorLocation();
@@ -421,43 +994,168 @@ void AMainCharacter::ForcePush()
 	// Get direction vector
 	FVector ForwardVector = this->GetActorForwardVector();
 
-	// Get end point based on blade's length
-	FVector EndPoint = StartPoint + (ForwardVector * 500);
+	FCollisionQueryParams CollisionParams(SCENE_QUERY_STAT(ForcePush), false, this);
 
-	FCollisionQueryParams CollisionParams;
-	CollisionParams.AddIgnoredActor(this->GetOwner());
+	// Collect every dynamic body in range with a single query, the cone is filtered below
+	TArray<FOverlapResult> Overlaps;
+	GetWorld()->OverlapMultiByObjectType(
+		Overlaps,
+		StartPoint,
+		FQuat::Identity,
+		FCollisionObjectQueryParams(FCollisionObjectQueryParams::AllDynamicObjects),
+		FCollisionShape::MakeSphere(ForcePushRange),
+		CollisionParams
+	);
 
-	// Save hit result
-	bool bIsHit = GetWorld()->LineTraceSingleByChannel(OutHit, StartPoint, EndPoint, ECC_Visibility, CollisionParams);
+	const float MinConeDot = FMath::Cos(FMath::DegreesToRadians(ForcePushAngle));
 
-	DrawDebugLine(GetWorld(), StartPoint, EndPoint, FColor::Purple, false, 1, 0, 1);
+	ForcePushTargets.Reset();
 
-	// Check if blade is colliding
-	if (bIsHit)
+	for (const FOverlapResult& Overlap : Overlaps)
 	{
-		//Get the static mesh of the chosen Actor
-		UStaticMeshComponent* SM = Cast<UStaticMeshComponent>(OutHit.Actor->GetRootComponent());
+		UPrimitiveComponent* Component = Overlap.GetComponent();
 
-		//If the static mesh is valid apply the given force
-		if (SM)
+		if (Component == nullptr || !Component->IsSimulatingPhysics() || ForcePushTargets.ContainsByPredicate([Component](const FForcePushTarget& Target) { return Target.Component == Component; }))
 		{
-			if (ForceVFX)
+			continue;
+		}
+
+		const FVector ToTarget = Component->Bounds.Origin - StartPoint;
+		const FVector Direction = ToTarget.GetSafeNormal();
+
+		// Bodies right on top of the character are pushed forward
+		if (!Direction.IsZero() && FVector::DotProduct(Direction, ForwardVector) < MinConeDot)
+		{
+			continue;
+		}
+
+		FBodyInstance* Body = Component->GetBodyInstance();
+
+		if (Body == nullptr)
+		{
+			continue;
+		}
+
+		FForcePushTarget& Target = ForcePushTargets.AddDefaulted_GetRef();
+		Target.Component = Component;
+		Target.Impulse = (Direction.IsZero() ? ForwardVector : Direction) * ForcePushStrength * Body->GetBodyMass();
+	}
+
+#if ENABLE_DRAW_DEBUG && !(UE_BUILD_SHIPPING || UE_BUILD_TEST)
+	if (CVarDebugForcePush.GetValueOnGameThread() != 0)
+	{
+		DrawDebugCone(GetWorld(), StartPoint, ForwardVector, ForcePushRange, FMath::DegreesToRadians(ForcePushAngle), FMath::DegreesToRadians(ForcePushAngle), 12, FColor::Purple, false, 1.f);
+	}
+#endif
+
+	if (ForcePushTargets.Num() == 0)
+	{
+		return;
+	}
+
+	TRACE_SWFL_COMBAT_EVENT(Push, this, nullptr, StartPoint);
+
+	// Apply every impulse under one lock of the physics scene instead of one round trip per body
+	FPhysicsCommand::ExecuteWrite(GetWorld()->GetPhysicsScene(), [this]()
+	{
+		for (const FForcePushTarget& Target : ForcePushTargets)
+		{
+			FBodyInstance* Body = Target.Component->GetBodyInstance();
+
+			if (Body && FPhysicsInterface::IsValid(Body->ActorHandle))
+			{
+				FPhysicsInterface::AddImpulse_AssumesLocked(Body->ActorHandle, Target.Impulse);
+			}
+		}
+	});
+
+	// One effect on the closest body pushed
+	if (ForceVFX)
+	{
+		const FForcePushTarget* Closest = nullptr;
+		float ClosestDistanceSquared = MAX_flt;
+
+		for (const FForcePushTarget& Target : ForcePushTargets)
+		{
+			const float DistanceSquared = FVector::DistSquared(Target.Component->Bounds.Origin, StartPoint);
+
+			if (DistanceSquared < ClosestDistanceSquared)
 			{
-				UGameplayStatics::SpawnEmitterAtLocation(
-					GetWorld(),
-					ForceVFX,
-					OutHit.ImpactPoint,
-					GetActorRotation(),
-					FVector(0.5f),
-					true,
-					EPSCPoolMethod::AutoRelease,
-					true
-				);
+				ClosestDistanceSquared = DistanceSquared;
+				Closest = &Target;
 			}
+		}
+
+		// Played here and sent to the clients which did not push
+		if (UCombatFXSubsystem* CombatFX = GetWorld()->GetSubsystem<UCombatFXSubsystem>())
+		{
+			CombatFX->AddEvent(ECombatFXType::CFX_PUSH, this, this, Closest->Component->Bounds.Origin);
+		}
+		else
+		{
+			PlayForcePushFX(Closest->Component->Bounds.Origin);
+		}
+	}
+
+#if !(UE_BUILD_SHIPPING || UE_BUILD_TEST)
+	if (CVarDebugForcePush.GetValueOnGameThread() != 0)
+	{
+		UE_LOG(LogTemp, Log, TEXT("Force push hit %d bodies"), ForcePushTargets.Num());
+	}
+#endif
+
+	ForcePushTargets.Reset();
+}
 
-			SM->AddImpulse(ForwardVector * 2000.f * SM->GetMass());
+void AMainCharacter::ClientPlayCombatFX_Implementation(const TArray<FCombatFXEvent>& Events)
+{
+	if (UCombatFXSubsystem* CombatFX = GetWorld()->GetSubsystem<UCombatFXSubsystem>())
+	{
+		CombatFX->PlayEvents(Events);
+	}
+}
+
+void AMainCharacter::PlayHitFX(const FVector& Location)
+{
+	// Hit sounds share a pool of voices
+	if (HitSFX)
+	{
+		ULightsaberAudioSubsystem* AudioSubsystem = GetWorld()->GetSubsystem<ULightsaberAudioSubsystem>();
 
-			UE_LOG(LogTemp, Warning, TEXT("Yes"));
+		if (AudioSubsystem)
+		{
+			AudioSubsystem->PlayHitSound(HitSFX, Location);
+		}
+		else
+		{
+			UGameplayStatics::PlaySoundAtLocation(this, HitSFX, Location);
 		}
 	}
+
+	if (HitVFX)
+	{
+		UGameplayStatics::SpawnEmitterAtLocation(this, HitVFX, Location);
+		SWFL_COUNT_FX_SPAWNED();
+	}
+}
+
+void AMainCharacter::PlayForcePushFX(const FVector& Location)
+{
+	if (ForceVFX == nullptr)
+	{
+		return;
+	}
+
+	UGameplayStatics::SpawnEmitterAtLocation(
+		GetWorld(),
+		ForceVFX,
+		Location,
+		GetActorRotation(),
+		FVector(0.5f),
+		true,
+		EPSCPoolMethod::AutoRelease,
+		true
+	);
+
+	SWFL_COUNT_FX_SPAWNED();
 }
@@ -0,0 +1,247 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SWFLCharacterMovementComponent.h"
+#include "GameFramework/Character.h"
+#include "MainCharacter.h"
+
+USWFLCharacterMovementComponent::USWFLCharacterMovementComponent()
+{
+	bWantsToDoubleJump = false;
+	bWantsToEvade = false;
+	bWantsToDoubleStep = false;
+}
+
+void USWFLCharacterMovementComponent::RequestDoubleJump()
+{
+	bWantsToDoubleJump = true;
+}
+
+void USWFLCharacterMovementComponent::RequestEvade()
+{
+	bWantsToEvade = true;
+}
+
+void USWFLCharacterMovementComponent::RequestDoubleStep()
+{
+	bWantsToDoubleStep = true;
+}
+
+void USWFLCharacterMovementComponent::UpdateFromCompressedFlags(uint8 Flags)
+{
+	Super::UpdateFromCompressedFlags(Flags);
+
+	bWantsToDoubleJump = (Flags & FSavedMove_SWFL::FLAG_DoubleJump) != 0;
+	bWantsToEvade = (Flags & FSavedMove_SWFL::FLAG_Evade) != 0;
+	bWantsToDoubleStep = (Flags & FSavedMove_SWFL::FLAG_DoubleStep) != 0;
+
+	SetWalking((Flags & FSavedMove_SWFL::FLAG_Jog) == 0);
+	SetSprinting((Flags & FSavedMove_SWFL::FLAG_Sprint) != 0);
+}
+
+void USWFLCharacterMovementComponent::SetWalking(bool bWalking)
+{
+	AMainCharacter* MainCharacter = Cast<AMainCharacter>(CharacterOwner);
+
+	if (MainCharacter && MainCharacter->GetIsWalking() != bWalking)
+	{
+		MainCharacter->SetWalking(bWalking);
+	}
+}
+
+void USWFLCharacterMovementComponent::SetSprinting(bool bSprinting)
+{
+	AMainCharacter* MainCharacter = Cast<AMainCharacter>(CharacterOwner);
+
+	if (MainCharacter == nullptr || MainCharacter->GetIsSprinting() == bSprinting)
+	{
+		return;
+	}
+
+	if (bSprinting)
+	{
+		MainCharacter->SprintOn();
+	}
+	else
+	{
+		MainCharacter->SprintOff();
+	}
+}
+
+FNetworkPredictionData_Client* USWFLCharacterMovementComponent::GetPredictionData_Client() const
+{
+	if (ClientPredictionData == nullptr)
+	{
+		USWFLCharacterMovementComponent* MutableThis = const_cast<USWFLCharacterMovementComponent*>(this);
+		MutableThis->ClientPredictionData = new FNetworkPredictionData_Client_SWFL(*this);
+	}
+
+	return ClientPredictionData;
+}
+
+void USWFLCharacterMovementComponent::UpdateCharacterStateBeforeMovement(float DeltaSeconds)
+{
+	Super::UpdateCharacterStateBeforeMovement(DeltaSeconds);
+
+	AMainCharacter* MainCharacter = Cast<AMainCharacter>(CharacterOwner);
+
+	// Requests are used up by the move that carries them, the saved move has already recorded them
+	const bool bDoubleJump = bWantsToDoubleJump;
+	const bool bEvade = bWantsToEvade;
+	const bool bDoubleStep = bWantsToDoubleStep;
+
+	bWantsToDoubleJump = false;
+	bWantsToEvade = false;
+	bWantsToDoubleStep = false;
+
+	if (MainCharacter == nullptr)
+	{
+		return;
+	}
+
+	// Replayed moves only redo the physics, the montages started by the original move are still playing
+	const bool bReplaying = CharacterOwner->bClientUpdating;
+
+	if (bDoubleJump)
+	{
+		MainCharacter->PerformDoubleJump(bReplaying);
+	}
+
+	if (bEvade)
+	{
+		MainCharacter->PerformEvade(bReplaying);
+	}
+
+	if (bDoubleStep)
+	{
+		MainCharacter->PerformDoubleStep(bReplaying);
+	}
+}
+
+FSavedMove_SWFL::FSavedMove_SWFL()
+	: bSavedWantsToDoubleJump(false)
+	, bSavedWantsToEvade(false)
+	, bSavedWantsToDoubleStep(false)
+	, bSavedSprinting(false)
+	, bSavedJogging(false)
+	, SavedDoubleJumpCounter(0)
+{
+}
+
+void FSavedMove_SWFL::Clear()
+{
+	Super::Clear();
+
+	bSavedWantsToDoubleJump = false;
+	bSavedWantsToEvade = false;
+	bSavedWantsToDoubleStep = false;
+	bSavedSprinting = false;
+	bSavedJogging = false;
+	SavedDoubleJumpCounter = 0;
+}
+
+uint8 FSavedMove_SWFL::GetCompressedFlags() const
+{
+	uint8 Flags = Super::GetCompressedFlags();
+
+	if (bSavedWantsToDoubleJump)
+	{
+		Flags |= FLAG_DoubleJump;
+	}
+
+	if (bSavedWantsToEvade)
+	{
+		Flags |= FLAG_Evade;
+	}
+
+	if (bSavedWantsToDoubleStep)
+	{
+		Flags |= FLAG_DoubleStep;
+	}
+
+	if (bSavedSprinting)
+	{
+		Flags |= FLAG_Sprint;
+	}
+
+	if (bSavedJogging)
+	{
+		Flags |= FLAG_Jog;
+	}
+
+	return Flags;
+}
+
+bool FSavedMove_SWFL::CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const
+{
+	const FSavedMove_SWFL* Other = static_cast<const FSavedMove_SWFL*>(NewMove.Get());
+
+	// Moves starting an ability are sent on their own, plain moves keep combining as usual
+	if (bSavedWantsToDoubleJump || bSavedWantsToEvade || bSavedWantsToDoubleStep
+		|| Other->bSavedWantsToDoubleJump || Other->bSavedWantsToEvade || Other->bSavedWantsToDoubleStep)
+	{
+		return false;
+	}
+
+	// A sprint or walk toggle changes the walk speed
+	if (bSavedSprinting != Other->bSavedSprinting || bSavedJogging != Other->bSavedJogging)
+	{
+		return false;
+	}
+
+	return Super::CanCombineWith(NewMove, InCharacter, MaxDelta);
+}
+
+void FSavedMove_SWFL::SetMoveFor(ACharacter* Character, float InDeltaTime, FVector const& NewAccel, FNetworkPredictionData_Client_Character& ClientData)
+{
+	Super::SetMoveFor(Character, InDeltaTime, NewAccel, ClientData);
+
+	const USWFLCharacterMovementComponent* Movement = Cast<USWFLCharacterMovementComponent>(Character->GetCharacterMovement());
+
+	if (Movement)
+	{
+		bSavedWantsToDoubleJump = Movement->bWantsToDoubleJump;
+		bSavedWantsToEvade = Movement->bWantsToEvade;
+		bSavedWantsToDoubleStep = Movement->bWantsToDoubleStep;
+	}
+
+	if (const AMainCharacter* MainCharacter = Cast<AMainCharacter>(Character))
+	{
+		SavedDoubleJumpCounter = static_cast<uint8>(MainCharacter->GetDoubleJumpCounter());
+		bSavedSprinting = MainCharacter->GetIsSprinting();
+		bSavedJogging = !MainCharacter->GetIsWalking();
+	}
+}
+
+void FSavedMove_SWFL::PrepMoveFor(ACharacter* Character)
+{
+	Super::PrepMoveFor(Character);
+
+	USWFLCharacterMovementComponent* Movement = Cast<USWFLCharacterMovementComponent>(Character->GetCharacterMovement());
+
+	if (Movement)
+	{
+		Movement->bWantsToDoubleJump = bSavedWantsToDoubleJump;
+		Movement->bWantsToEvade = bSavedWantsToEvade;
+		Movement->bWantsToDoubleStep = bSavedWantsToDoubleStep;
+
+		// Replays run at the walk speed the move was made with
+		Movement->SetWalking(!bSavedJogging);
+		Movement->SetSprinting(bSavedSprinting);
+	}
+
+	if (AMainCharacter* MainCharacter = Cast<AMainCharacter>(Character))
+	{
+		MainCharacter->SetDoubleJumpCounter(SavedDoubleJumpCounter);
+	}
+}
+
+FNetworkPredictionData_Client_SWFL::FNetworkPredictionData_Client_SWFL(const UCharacterMovementComponent& ClientMovement)
+	: Super(ClientMovement)
+{
+}
+
+FSavedMovePtr FNetworkPredictionData_Client_SWFL::AllocateNewMove()
+{
+	return FSavedMovePtr(new FSavedMove_SWFL());
+}
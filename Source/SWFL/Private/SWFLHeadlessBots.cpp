@@ -0,0 +1,88 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SWFLHeadlessBots.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/GameModeBase.h"
+#include "GameFramework/PlayerStart.h"
+#include "GameFramework/Controller.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Misc/CommandLine.h"
+#include "MainCharacter.h"
+
+namespace SWFLHeadlessBots
+{
+	bool IsRequested(const UObject* Outer, const TCHAR* Switch)
+	{
+		const UWorld* World = Cast<UWorld>(Outer);
+
+		return World && World->IsGameWorld() && FParse::Param(FCommandLine::Get(), Switch);
+	}
+
+	UClass* ResolveCharacterClass(UWorld* World, const TSoftClassPtr<AMainCharacter>& CharacterClass, const TCHAR* LogPrefix)
+	{
+		UClass* Class = CharacterClass.LoadSynchronous();
+
+		if (Class == nullptr && World->GetAuthGameMode())
+		{
+			Class = World->GetAuthGameMode()->DefaultPawnClass;
+		}
+
+		if (Class == nullptr || !Class->IsChildOf(AMainCharacter::StaticClass()))
+		{
+			UE_LOG(LogTemp, Error, TEXT("%s: no AMainCharacter class to spawn, set CharacterClass in DefaultGame.ini"), LogPrefix);
+			return nullptr;
+		}
+
+		return Class;
+	}
+
+	FVector GetSpawnOrigin(UWorld* World)
+	{
+		for (TActorIterator<APlayerStart> It(World); It; ++It)
+		{
+			return It->GetActorLocation();
+		}
+
+		return FVector(0.f, 0.f, 100.f);
+	}
+
+	AMainCharacter* SpawnBot(UWorld* World, UClass* Class, const FVector& Location, const FRotator& Rotation)
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+
+		AMainCharacter* Character = World->SpawnActor<AMainCharacter>(Class, Location, Rotation, SpawnParams);
+
+		if (Character == nullptr)
+		{
+			return nullptr;
+		}
+
+		// Movement runs through a controller, as it does for players
+		Character->SpawnDefaultController();
+
+		// Nothing is rendered under -nullrhi, montages still have to play for their notifies to fire
+		Character->GetMesh()->VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::AlwaysTickPoseAndRefreshBones;
+
+		return Character;
+	}
+
+	void DestroyBot(AMainCharacter* Character)
+	{
+		if (Character == nullptr)
+		{
+			return;
+		}
+
+		AController* Controller = Character->GetController();
+
+		Character->Destroy();
+
+		if (Controller)
+		{
+			Controller->Destroy();
+		}
+	}
+}
@@ -0,0 +1,257 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SWFLMicroBenchmarkCommandlet.h"
+#include "Engine/World.h"
+#include "Engine/Engine.h"
+#include "Engine/CollisionProfile.h"
+#include "Components/BoxComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "Particles/ParticleSystem.h"
+#include "HAL/MemoryBase.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonSerializer.h"
+#include "Dom/JsonObject.h"
+#include "Lightsaber.h"
+#include "MainCharacter.h"
+
+namespace SWFLMicroBenchmark
+{
+	// Allocator calls made by the whole process so far, read from the allocator's own counters instead of replacing GMalloc
+	// Other threads of the commandlet are mostly idle so their few allocations barely move the count, builds without stats report 0
+	FORCEINLINE uint64 GetNumAllocations()
+	{
+#if UE_STATS
+		return FMalloc::TotalMallocCalls.Load(EMemoryOrder::Relaxed) + FMalloc::TotalReallocCalls.Load(EMemoryOrder::Relaxed);
+#else
+		return 0;
+#endif
+	}
+
+	struct FResult
+	{
+		FString Name;
+		int64 NumOps = 0;
+		double MeanNs = 0.0;
+		double P50Ns = 0.0;
+		double P99Ns = 0.0;
+		double AllocsPerOp = 0.0;
+	};
+
+	/**
+	 * Run Op in NumSamples timed batches of OpsPerSample calls, after as many untimed warmup batches.
+	 * Batches keep the timer's own cost out of routines which take a few nanoseconds.
+	 * BetweenSamples runs outside of the measure.
+	 */
+	template<typename OpType, typename BetweenType>
+	FResult Run(const TCHAR* Name, int32 NumSamples, int32 OpsPerSample, OpType&& Op, BetweenType&& BetweenSamples)
+	{
+		TArray<double> SampleNs;
+		SampleNs.Reserve(NumSamples);
+
+		int64 OpIndex = 0;
+		uint64 NumAllocations = 0;
+		double TotalNs = 0.0;
+
+		for (int32 Sample = -NumSamples / 10; Sample < NumSamples; ++Sample)
+		{
+			const uint64 AllocationsBefore = GetNumAllocations();
+			const uint64 StartCycles = FPlatformTime::Cycles64();
+
+			for (int32 Index = 0; Index < OpsPerSample; ++Index)
+			{
+				Op(OpIndex++);
+			}
+
+			const uint64 EndCycles = FPlatformTime::Cycles64();
+			const uint64 AllocationsAfter = GetNumAllocations();
+
+			BetweenSamples();
+
+			// Negative samples are warmup
+			if (Sample < 0)
+			{
+				continue;
+			}
+
+			const double Ns = FPlatformTime::ToMilliseconds64(EndCycles - StartCycles) * 1000000.0;
+
+			SampleNs.Add(Ns / OpsPerSample);
+			TotalNs += Ns;
+			NumAllocations += AllocationsAfter - AllocationsBefore;
+		}
+
+		SampleNs.Sort();
+
+		FResult Result;
+		Result.Name = Name;
+		Result.NumOps = int64(NumSamples) * OpsPerSample;
+		Result.MeanNs = TotalNs / FMath::Max<int64>(Result.NumOps, 1);
+		Result.P50Ns = SampleNs.Num() > 0 ? SampleNs[SampleNs.Num() / 2] : 0.0;
+		Result.P99Ns = SampleNs.Num() > 0 ? SampleNs[FMath::Min((SampleNs.Num() * 99) / 100, SampleNs.Num() - 1)] : 0.0;
+		Result.AllocsPerOp = double(NumAllocations) / FMath::Max<int64>(Result.NumOps, 1);
+
+		return Result;
+	}
+
+	template<typename OpType>
+	FResult Run(const TCHAR* Name, int32 NumSamples, int32 OpsPerSample, OpType&& Op)
+	{
+		return Run(Name, NumSamples, OpsPerSample, Forward<OpType>(Op), []() {});
+	}
+
+	AActor* SpawnBox(UWorld* World, const FVector& Location, const FVector& Extent)
+	{
+		AActor* Actor = World->SpawnActor<AActor>(AActor::StaticClass(), Location, FRotator::ZeroRotator);
+
+		UBoxComponent* Box = NewObject<UBoxComponent>(Actor);
+		Box->SetBoxExtent(Extent);
+		Box->SetCollisionProfileName(UCollisionProfile::BlockAll_ProfileName);
+		Actor->SetRootComponent(Box);
+		Box->RegisterComponent();
+		Box->SetWorldLocation(Location);
+
+		return Actor;
+	}
+}
+
+USWFLMicroBenchmarkCommandlet::USWFLMicroBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 USWFLMicroBenchmarkCommandlet::Main(const FString& Params)
+{
+	using namespace SWFLMicroBenchmark;
+
+	int32 NumSamples = 2000;
+	FParse::Value(*Params, TEXT("samples="), NumSamples);
+	NumSamples = FMath::Max(NumSamples, 10);
+
+	FString OutputPath = FPaths::Combine(FPaths::ProfilingDir(), TEXT("SWFLMicroBenchmark.json"));
+	FParse::Value(*Params, TEXT("output="), OutputPath);
+
+	// Synthetic world, a grid of boxes and nothing else
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("SWFLMicroBenchmark"));
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+
+	for (int32 X = 0; X < 8; ++X)
+	{
+		for (int32 Y = 0; Y < 8; ++Y)
+		{
+			SpawnBox(World, FVector(X * 300.f, Y * 300.f, 100.f), FVector(40.f));
+		}
+	}
+
+	// One saber right under a box, one far from all of them
+	ALightsaber* HitLightsaber = World->SpawnActor<ALightsaber>(ALightsaber::StaticClass(), FVector(0.f, 0.f, 30.f), FRotator::ZeroRotator);
+	ALightsaber* MissLightsaber = World->SpawnActor<ALightsaber>(ALightsaber::StaticClass(), FVector(-5000.f, -5000.f, 30.f), FRotator::ZeroRotator);
+
+	UParticleSystem* EmptyVFX = NewObject<UParticleSystem>(GetTransientPackage());
+
+	TArray<FResult> Results;
+
+	// Blade interpolation, as in ALightsaber::Tick and the blade simulation
+	{
+		float Scale = 0.f;
+
+		// Written on every op so the optimizer keeps the math
+		volatile float Sink = 0.f;
+
+		Results.Add(Run(TEXT("BladeInterpolation"), NumSamples, 1024, [&Scale, &Sink](int64 Index)
+		{
+			float LightIntensity;
+			bool bVisible;
+
+			// Alternate ignition and retraction so the blade never settles
+			const float Target = ((Index >> 6) & 1) ? 0.f : 1.f;
+			Scale = ALightsaber::StepBladeScale(Scale, Target, 1.f / 60.f, 8.f, 2000.f, LightIntensity, bVisible);
+			Sink = Sink + (bVisible ? LightIntensity : 0.f);
+		}));
+	}
+
+	// Blade trace against the synthetic world
+	if (HitLightsaber && MissLightsaber)
+	{
+		Results.Add(Run(TEXT("RayCast.Hit"), NumSamples, 16, [HitLightsaber](int64 Index)
+		{
+			float ScaleLimit = 1.f;
+			float CollisionScale;
+			HitLightsaber->RayCast(ScaleLimit, CollisionScale);
+		}));
+
+		Results.Add(Run(TEXT("RayCast.Miss"), NumSamples, 16, [MissLightsaber](int64 Index)
+		{
+			float ScaleLimit = 1.f;
+			float CollisionScale;
+			MissLightsaber->RayCast(ScaleLimit, CollisionScale);
+		}));
+
+		// Pooled emitters come back once the world has ticked, which is not part of the measure
+		Results.Add(Run(TEXT("SpawnHiltVFX"), NumSamples / 4, 8, [HitLightsaber, EmptyVFX](int64 Index)
+		{
+			HitLightsaber->SpawnHiltVFX(EmptyVFX, HitLightsaber->GetHilt(), HitLightsaber->GetHiltSocket(), FVector(0), FRotator(0), FVector(0.2));
+		},
+		[World]()
+		{
+			World->Tick(LEVELTICK_All, 1.f / 60.f);
+		}));
+	}
+
+	// Direction math of MoveForward and MoveRight
+	{
+		volatile float Sink = 0.f;
+
+		Results.Add(Run(TEXT("MovementDirection"), NumSamples, 1024, [&Sink](int64 Index)
+		{
+			const FRotator ControlRotation(-15.f, float(Index % 360), 0.f);
+			const FVector Forward = AMainCharacter::GetMovementDirection(ControlRotation, EAxis::X);
+			const FVector Right = AMainCharacter::GetMovementDirection(ControlRotation, EAxis::Y);
+			Sink = Sink + Forward.X + Forward.Y + Right.X + Right.Y;
+		}));
+	}
+
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+
+	TArray<TSharedPtr<FJsonValue>> JsonResults;
+
+	for (const FResult& Result : Results)
+	{
+		TSharedPtr<FJsonObject> JsonResult = MakeShared<FJsonObject>();
+		JsonResult->SetStringField(TEXT("name"), Result.Name);
+		JsonResult->SetNumberField(TEXT("ops"), double(Result.NumOps));
+		JsonResult->SetNumberField(TEXT("ns_per_op"), Result.MeanNs);
+		JsonResult->SetNumberField(TEXT("p50_ns"), Result.P50Ns);
+		JsonResult->SetNumberField(TEXT("p99_ns"), Result.P99Ns);
+		JsonResult->SetNumberField(TEXT("allocs_per_op"), Result.AllocsPerOp);
+
+		JsonResults.Add(MakeShared<FJsonValueObject>(JsonResult));
+
+		UE_LOG(LogTemp, Display, TEXT("%-20s %10.1f ns/op  p50 %10.1f  p99 %10.1f  %6.3f allocs/op"),
+			*Result.Name, Result.MeanNs, Result.P50Ns, Result.P99Ns, Result.AllocsPerOp);
+	}
+
+	TSharedRef<FJsonObject> Json = MakeShared<FJsonObject>();
+	Json->SetNumberField(TEXT("samples"), NumSamples);
+	Json->SetArrayField(TEXT("results"), JsonResults);
+
+	FString Output;
+	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Output);
+	FJsonSerializer::Serialize(Json, Writer);
+
+	if (!FFileHelper::SaveStringToFile(Output, *OutputPath))
+	{
+		UE_LOG(LogTemp, Error, TEXT("SWFLMicroBenchmark: could not write %s"), *OutputPath);
+		return 1;
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("SWFLMicroBenchmark: results written to %s"), *OutputPath);
+
+	return 0;
+}
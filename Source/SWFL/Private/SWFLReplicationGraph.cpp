@@ -0,0 +1,228 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SWFLReplicationGraph.h"
+#include "Engine/World.h"
+#include "GameFramework/GameStateBase.h"
+#include "GameFramework/Info.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/PlayerState.h"
+#include "UObject/UObjectIterator.h"
+#include "Lightsaber.h"
+#include "MainCharacter.h"
+
+void USWFLReplicationGraph::InitGlobalActorClassSettings()
+{
+	Super::InitGlobalActorClassSettings();
+
+	for (TObjectIterator<UClass> It; It; ++It)
+	{
+		UClass* Class = *It;
+		const AActor* ActorCDO = Cast<AActor>(Class->GetDefaultObject());
+
+		if (ActorCDO == nullptr || !ActorCDO->GetIsReplicated())
+		{
+			continue;
+		}
+
+		// Leftovers of blueprint compilation
+		if (Class->GetName().StartsWith(TEXT("SKEL_")) || Class->GetName().StartsWith(TEXT("REINST_")))
+		{
+			continue;
+		}
+
+		const ESWFLClassRepNodeMapping Policy = GetMappingPolicy(Class);
+		ClassRepNodePolicies.Set(Class, Policy);
+
+		const bool bSpatialize = Policy == ESWFLClassRepNodeMapping::Spatialize_Dynamic
+			|| Policy == ESWFLClassRepNodeMapping::Spatialize_Dormancy
+			|| Policy == ESWFLClassRepNodeMapping::Spatialize_Static;
+
+		FClassReplicationInfo ClassInfo;
+		InitClassReplicationInfo(ClassInfo, Class, bSpatialize);
+
+		// Characters use the arena's cull distance whatever their blueprint says, blueprints loaded later inherit it from the native class
+		if (Class->IsChildOf(AMainCharacter::StaticClass()))
+		{
+			ClassInfo.SetCullDistanceSquared(FMath::Square(CharacterCullDistance));
+		}
+
+		GlobalActorReplicationInfoMap.SetClassInfo(Class, ClassInfo);
+	}
+}
+
+void USWFLReplicationGraph::InitGlobalGraphNodes()
+{
+	GridNode = CreateNewNode<UReplicationGraphNode_GridSpatialization2D>();
+	GridNode->CellSize = SpatialCellSize;
+	GridNode->SpatialBias = FVector2D(SpatialBiasX, SpatialBiasY);
+	AddGlobalGraphNode(GridNode);
+
+	AlwaysRelevantNode = CreateNewNode<UReplicationGraphNode_ActorList>();
+	AddGlobalGraphNode(AlwaysRelevantNode);
+
+	FrequencyLimitedNode = CreateNewNode<UReplicationGraphNode_ActorListFrequencyBuckets>();
+	AddGlobalGraphNode(FrequencyLimitedNode);
+}
+
+void USWFLReplicationGraph::InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection)
+{
+	Super::InitConnectionGraphNodes(RepGraphConnection);
+
+	USWFLReplicationGraphNode_AlwaysRelevant_ForConnection* AlwaysRelevantForConnectionNode = CreateNewNode<USWFLReplicationGraphNode_AlwaysRelevant_ForConnection>();
+	AddConnectionGraphNode(AlwaysRelevantForConnectionNode, RepGraphConnection);
+}
+
+void USWFLReplicationGraph::RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo)
+{
+	const ESWFLClassRepNodeMapping* Policy = ClassRepNodePolicies.Get(ActorInfo.Class);
+
+	switch (Policy ? *Policy : ESWFLClassRepNodeMapping::NotRouted)
+	{
+	case ESWFLClassRepNodeMapping::RelevantAllConnections:
+		AlwaysRelevantNode->NotifyAddNetworkActor(ActorInfo);
+		break;
+	case ESWFLClassRepNodeMapping::FrequencyLimited:
+		FrequencyLimitedNode->NotifyAddNetworkActor(ActorInfo);
+		break;
+	case ESWFLClassRepNodeMapping::Spatialize_Dynamic:
+		GridNode->AddActor_Dynamic(ActorInfo, GlobalInfo);
+		break;
+	case ESWFLClassRepNodeMapping::Spatialize_Dormancy:
+		GridNode->AddActor_Dormancy(ActorInfo, GlobalInfo);
+		break;
+	case ESWFLClassRepNodeMapping::Spatialize_Static:
+		GridNode->AddActor_Static(ActorInfo, GlobalInfo);
+		break;
+	case ESWFLClassRepNodeMapping::Dependent:
+		// Sabers are spawned with their wielder as owner
+		if (AActor* Owner = ActorInfo.Actor->GetOwner())
+		{
+			GlobalActorReplicationInfoMap.AddDependentActor(Owner, ActorInfo.Actor);
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+void USWFLReplicationGraph::RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo)
+{
+	const ESWFLClassRepNodeMapping* Policy = ClassRepNodePolicies.Get(ActorInfo.Class);
+
+	switch (Policy ? *Policy : ESWFLClassRepNodeMapping::NotRouted)
+	{
+	case ESWFLClassRepNodeMapping::RelevantAllConnections:
+		AlwaysRelevantNode->NotifyRemoveNetworkActor(ActorInfo);
+		break;
+	case ESWFLClassRepNodeMapping::FrequencyLimited:
+		FrequencyLimitedNode->NotifyRemoveNetworkActor(ActorInfo);
+		break;
+	case ESWFLClassRepNodeMapping::Spatialize_Dynamic:
+		GridNode->RemoveActor_Dynamic(ActorInfo);
+		break;
+	case ESWFLClassRepNodeMapping::Spatialize_Dormancy:
+		GridNode->RemoveActor_Dormancy(ActorInfo);
+		break;
+	case ESWFLClassRepNodeMapping::Spatialize_Static:
+		GridNode->RemoveActor_Static(ActorInfo);
+		break;
+	case ESWFLClassRepNodeMapping::Dependent:
+		if (AActor* Owner = ActorInfo.Actor->GetOwner())
+		{
+			GlobalActorReplicationInfoMap.RemoveDependentActor(Owner, ActorInfo.Actor);
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+void USWFLReplicationGraph::SetDependentOwner(AActor* Actor, AActor* OldOwner, AActor* NewOwner)
+{
+	if (Actor == nullptr || OldOwner == NewOwner)
+	{
+		return;
+	}
+
+	if (OldOwner)
+	{
+		GlobalActorReplicationInfoMap.RemoveDependentActor(OldOwner, Actor);
+	}
+
+	if (NewOwner)
+	{
+		GlobalActorReplicationInfoMap.AddDependentActor(NewOwner, Actor);
+	}
+}
+
+ESWFLClassRepNodeMapping USWFLReplicationGraph::GetMappingPolicy(UClass* Class) const
+{
+	const AActor* ActorCDO = Class->GetDefaultObject<AActor>();
+
+	if (Class->IsChildOf(ALightsaber::StaticClass()))
+	{
+		return ESWFLClassRepNodeMapping::Dependent;
+	}
+
+	if (Class->IsChildOf(APlayerController::StaticClass()) || ActorCDO->bOnlyRelevantToOwner)
+	{
+		return ESWFLClassRepNodeMapping::NotRouted;
+	}
+
+	if (Class->IsChildOf(AGameStateBase::StaticClass()))
+	{
+		return ESWFLClassRepNodeMapping::RelevantAllConnections;
+	}
+
+	// Scores and names change a few times per match, nobody needs them every frame
+	if (Class->IsChildOf(APlayerState::StaticClass()) || Class->IsChildOf(AInfo::StaticClass()))
+	{
+		return ESWFLClassRepNodeMapping::FrequencyLimited;
+	}
+
+	if (ActorCDO->bAlwaysRelevant)
+	{
+		return ESWFLClassRepNodeMapping::RelevantAllConnections;
+	}
+
+	if (Class->IsChildOf(APawn::StaticClass()) || ActorCDO->IsReplicatingMovement())
+	{
+		return ESWFLClassRepNodeMapping::Spatialize_Dynamic;
+	}
+
+	return ActorCDO->NetDormancy > DORM_Awake ? ESWFLClassRepNodeMapping::Spatialize_Dormancy : ESWFLClassRepNodeMapping::Spatialize_Static;
+}
+
+void USWFLReplicationGraph::InitClassReplicationInfo(FClassReplicationInfo& Info, UClass* Class, bool bSpatialize) const
+{
+	const AActor* ActorCDO = Class->GetDefaultObject<AActor>();
+
+	if (bSpatialize)
+	{
+		Info.SetCullDistanceSquared(ActorCDO->NetCullDistanceSquared);
+	}
+
+	Info.ReplicationPeriodFrame = GetReplicationPeriodFrameForFrequency(FMath::Max(ActorCDO->NetUpdateFrequency, 1.f));
+}
+
+void USWFLReplicationGraphNode_AlwaysRelevant_ForConnection::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
+{
+	ReplicationActorList.Reset();
+
+	for (const FNetViewer& Viewer : Params.Viewers)
+	{
+		ReplicationActorList.ConditionalAdd(Viewer.InViewer);
+		ReplicationActorList.ConditionalAdd(Viewer.ViewTarget);
+
+		if (const APlayerController* PlayerController = Cast<APlayerController>(Viewer.InViewer))
+		{
+			// The own pawn is needed even out of the grid, its sabers follow as dependents
+			ReplicationActorList.ConditionalAdd(PlayerController->GetPawn());
+			ReplicationActorList.ConditionalAdd(PlayerController->PlayerState);
+		}
+	}
+
+	Params.OutGatheredReplicationLists.AddReplicationActorList(ReplicationActorList);
+}
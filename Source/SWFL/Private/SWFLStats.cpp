@@ -0,0 +1,56 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SWFLStats.h"
+
+DEFINE_STAT(STAT_SWFL_LightsaberTick);
+DEFINE_STAT(STAT_SWFL_RayCast);
+DEFINE_STAT(STAT_SWFL_SweepBlade);
+DEFINE_STAT(STAT_SWFL_DoDamage);
+DEFINE_STAT(STAT_SWFL_Simulate);
+DEFINE_STAT(STAT_SWFL_Clash);
+DEFINE_STAT(STAT_SWFL_ResolveHits);
+DEFINE_STAT(STAT_SWFL_MeleeAttack);
+DEFINE_STAT(STAT_SWFL_ForcePush);
+DEFINE_STAT(STAT_SWFL_CombatFXBatch);
+
+DEFINE_STAT(STAT_SWFL_BladeTraces);
+DEFINE_STAT(STAT_SWFL_FXSpawned);
+DEFINE_STAT(STAT_SWFL_HitsResolved);
+DEFINE_STAT(STAT_SWFL_CombatFXBatches);
+DEFINE_STAT(STAT_SWFL_CombatFXEvents);
+
+DEFINE_STAT(STAT_SWFL_SabersTicking);
+DEFINE_STAT(STAT_SWFL_BurnMarksAlive);
+DEFINE_STAT(STAT_SWFL_HumVoices);
+
+CSV_DEFINE_CATEGORY_MODULE(SWFL_API, SWFL, true);
+
+#if UE_TRACE_ENABLED
+
+UE_TRACE_CHANNEL_DEFINE(SWFLCombatChannel)
+
+UE_TRACE_EVENT_BEGIN(SWFL, CombatEvent)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(uint32, InstigatorId)
+	UE_TRACE_EVENT_FIELD(uint32, TargetId)
+	UE_TRACE_EVENT_FIELD(float, LocationX)
+	UE_TRACE_EVENT_FIELD(float, LocationY)
+	UE_TRACE_EVENT_FIELD(float, LocationZ)
+	UE_TRACE_EVENT_FIELD(uint8, Type)
+UE_TRACE_EVENT_END()
+
+void SWFLTrace::OutputCombatEvent(ESWFLCombatEvent Type, const UObject* Instigator, const UObject* Target, const FVector& Location)
+{
+	// Same clock as the CPU timing events, so combat events line up with the frame they happened in
+	UE_TRACE_LOG(SWFL, CombatEvent, SWFLCombatChannel)
+		<< CombatEvent.Cycle(FPlatformTime::Cycles64())
+		<< CombatEvent.InstigatorId(Instigator ? Instigator->GetUniqueID() : 0)
+		<< CombatEvent.TargetId(Target ? Target->GetUniqueID() : 0)
+		<< CombatEvent.LocationX(Location.X)
+		<< CombatEvent.LocationY(Location.Y)
+		<< CombatEvent.LocationZ(Location.Z)
+		<< CombatEvent.Type(uint8(Type));
+}
+
+#endif
@@ -0,0 +1,129 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "BotSoakTestSubsystem.generated.h"
+
+/**
+ * Long-running headless soak test looking for memory creep.
+ * AI controlled characters wander and spam attacks, pushes, evades, jumps and saber toggles for hours, part of them
+ * is respawned regularly. Object counts per class, live particle, decal and audio components and process memory are
+ * sampled after a garbage collection and written to Saved/Profiling/BotSoakTest.csv. The test fails, and exits with
+ * an error code, when any of them stays above its baseline plus tolerance for several samples in a row.
+ *
+ * SWFL /Game/Levels/Test -game -nullrhi -unattended -BotSoakTest [-SoakBots=32] [-SoakDuration=14400]
+ */
+UCLASS(Config = Game)
+class SWFL_API UBotSoakTestSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	// Only game worlds launched with -BotSoakTest run the soak
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	// Drive the bots and sample memory
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+	virtual TStatId GetStatId() const override;
+
+private:
+	// Character spawned as bot, the game mode's default pawn when unset
+	UPROPERTY(Config)
+	TSoftClassPtr<class AMainCharacter> CharacterClass;
+
+	UPROPERTY(Config)
+	int32 NumBots = 32;
+
+	// Total length of the soak, in seconds
+	UPROPERTY(Config)
+	float SoakDuration = 14400.f;
+
+	// Time before the baseline sample, pools and caches fill up during it
+	UPROPERTY(Config)
+	float WarmupTime = 120.f;
+
+	UPROPERTY(Config)
+	float SampleInterval = 30.f;
+
+	// Every interval this fraction of the bots is destroyed and spawned again
+	UPROPERTY(Config)
+	float RespawnInterval = 120.f;
+
+	UPROPERTY(Config)
+	float RespawnFraction = 0.25f;
+
+	// Average time between two actions of a bot
+	UPROPERTY(Config)
+	float ActionInterval = 0.6f;
+
+	// A value grows without bound once it is above Baseline * MaxGrowthRatio + its slack for NumSamplesToFail samples in a row
+	UPROPERTY(Config)
+	float MaxGrowthRatio = 1.25f;
+
+	UPROPERTY(Config)
+	int32 ObjectCountSlack = 200;
+
+	UPROPERTY(Config)
+	int32 ComponentCountSlack = 50;
+
+	UPROPERTY(Config)
+	float MemorySlackMB = 64.f;
+
+	UPROPERTY(Config)
+	int32 NumSamplesToFail = 4;
+
+	UPROPERTY(Config)
+	bool bExitWhenDone = true;
+
+	struct FBot
+	{
+		TWeakObjectPtr<AMainCharacter> Character;
+		FVector WanderDirection;
+		float NextActionTime;
+		float NextWanderTime;
+	};
+
+	TArray<FBot> Bots;
+
+	// Every tracked value, the per class object counts use the class path as name
+	struct FTrackedValue
+	{
+		double Baseline = 0.0;
+		double Last = 0.0;
+		double Slack = 0.0;
+		int32 NumSamplesOverLimit = 0;
+	};
+
+	TMap<FString, FTrackedValue> TrackedValues;
+
+	float StartTime = 0.f;
+	float NextSampleTime = 0.f;
+	float NextRespawnTime = 0.f;
+
+	// Garbage is collected the frame before a sample, so only leaked objects are counted
+	bool bSamplePending = false;
+	bool bHasBaseline = false;
+	bool bStarted = false;
+	bool bDone = false;
+	bool bFailed = false;
+
+	FString CsvPath;
+
+	FRandomStream RandomStream;
+
+	void SpawnBot();
+	void DriveBots(float Now);
+	void RespawnBots();
+	void DestroyBots();
+	void TakeSample(float Now);
+	void TrackValue(const FString& Name, double Value, double Slack);
+	void Finish();
+};
@@ -0,0 +1,130 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "Engine/NetSerialization.h"
+#include "CombatFXSubsystem.generated.h"
+
+UENUM()
+enum class ECombatFXType : uint8
+{
+	CFX_HIT UMETA(DisplayName = "Hit"),
+	CFX_CLASH UMETA(DisplayName = "Clash"),
+	CFX_PUSH UMETA(DisplayName = "Push"),
+	CFX_IMPACT UMETA(DisplayName = "Impact"),
+
+	CFX_MAX UMETA(DisplayName = "DefaultMAX")
+};
+
+// One cosmetic combat effect as sent to clients
+USTRUCT()
+struct FCombatFXEvent
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	ECombatFXType Type = ECombatFXType::CFX_HIT;
+
+	// Actor playing the effect with its own assets: victim of a hit, pushing character, saber of an impact or clash
+	UPROPERTY()
+	AActor* Source = nullptr;
+
+	UPROPERTY()
+	FVector Location = FVector::ZeroVector;
+
+	UPROPERTY()
+	FVector Normal = FVector::ZeroVector;
+
+	// Type in 2 bits, location to a tenth of a unit, normal to 8 bits per axis and only for contacts
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FCombatFXEvent> : public TStructOpsTypeTraitsBase2<FCombatFXEvent>
+{
+	enum
+	{
+		WithNetSerializer = true
+	};
+};
+
+/**
+ * Plays hit, clash, push and impact effects and gathers the ones raised on a server during a frame.
+ * At the end of the frame each remote client gets a single unreliable batch with the events it can see:
+ * close enough to its view, from actors relevant to it, and not already predicted by its own pawn.
+ * A continuous contact of a saber is only sent at its start and then every ImpactResendInterval.
+ */
+UCLASS(Config = Game)
+class SWFL_API UCombatFXSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	// Play an effect here, and on a server queue it for the clients, Instigator is the character causing it
+	void AddEvent(ECombatFXType Type, AActor* Source, const AActor* Instigator, const FVector& Location, const FVector& Normal = FVector::ZeroVector);
+
+	// Effects of a batch received from the server
+	void PlayEvents(const TArray<FCombatFXEvent>& Events);
+
+	// Send this frame's events to the clients
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+	virtual TStatId GetStatId() const override;
+
+	FORCEINLINE int32 GetNumEventsSent() const { return NumEventsSent; }
+	FORCEINLINE int32 GetNumBatchesSent() const { return NumBatchesSent; }
+	FORCEINLINE int32 GetNumCulled() const { return NumCulled; }
+	FORCEINLINE int32 GetNumCoalesced() const { return NumCoalesced; }
+
+private:
+	void PlayEvent(const FCombatFXEvent& Event);
+
+	// Events farther than this from a client's view point are not sent to it
+	UPROPERTY(Config)
+	float MaxEventDistance = 5000.f;
+
+	// Events past this count in a frame are dropped, in the order they were raised
+	UPROPERTY(Config)
+	int32 MaxEventsPerBatch = 32;
+
+	// Impacts of a saber still in contact are sent at most this often, below the impact subsystem's merge time
+	UPROPERTY(Config)
+	float ImpactResendInterval = 0.1f;
+
+	struct FPendingEvent
+	{
+		ECombatFXType Type;
+		TWeakObjectPtr<AActor> Source;
+		TWeakObjectPtr<const AActor> Instigator;
+		FVector Location;
+		FVector Normal;
+	};
+
+	TArray<FPendingEvent> PendingEvents;
+
+	struct FImpactContact
+	{
+		float LastImpactTime;
+		float LastSentTime;
+	};
+
+	// Contacts of the sabers touching geometry, to send a drag as a few impacts
+	TMap<TWeakObjectPtr<AActor>, FImpactContact> ImpactContacts;
+
+	// Whether an impact of Source continues its contact and was sent recently enough to skip it
+	bool ShouldCoalesceImpact(AActor* Source, float Now);
+
+	// Kept between clients and frames to avoid reallocating
+	TArray<FCombatFXEvent> Batch;
+
+	// Totals since the world started
+	int32 NumEventsSent = 0;
+	int32 NumBatchesSent = 0;
+	int32 NumCulled = 0;
+	int32 NumCoalesced = 0;
+};
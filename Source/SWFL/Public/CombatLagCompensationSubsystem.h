@@ -0,0 +1,83 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "CombatLagCompensationSubsystem.generated.h"
+
+/**
+ * Server-side history of character capsules and blade segments, used to validate the blade hits claimed by clients.
+ * Every character keeps a fixed-size ring buffer of its recent poses, recording never allocates.
+ * A claim is checked against the poses of attacker and victim rewound to the time the attacker saw them.
+ */
+UCLASS(Config = Game)
+class SWFL_API UCombatLagCompensationSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	// Called by characters on the server
+	void RegisterCharacter(class AMainCharacter* Character);
+	void UnregisterCharacter(AMainCharacter* Character);
+
+	// Whether the blade segment claimed by Attacker for its left (0) or right (1) saber could have touched Victim at ViewTime, in server world time
+	bool ValidateBladeHit(AMainCharacter* Attacker, int32 Side, AMainCharacter* Victim, const FVector& ClaimedBase, const FVector& ClaimedTip, float ViewTime) const;
+
+	// Record the poses of this frame, once every character has moved
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+	virtual TStatId GetStatId() const override;
+
+	// Poses kept per character, HistoryDuration is spread over them
+	static constexpr int32 MaxPoses = 32;
+
+private:
+	// How far back claims can be rewound, in seconds
+	UPROPERTY(Config)
+	float HistoryDuration = 0.25f;
+
+	// The claimed blade base must be this close to the attacker's capsule
+	UPROPERTY(Config)
+	float MaxGripDistance = 120.f;
+
+	// Slack given to claims for quantization, interpolation and the radius of the blade
+	UPROPERTY(Config)
+	float HitTolerance = 20.f;
+
+	struct FCombatPose
+	{
+		float Time;
+		FVector CapsuleLocation;
+
+		// Left and right sabers, a zero length blade is retracted
+		FVector BladeBase[2];
+		FVector BladeTip[2];
+	};
+
+	struct FPoseHistory
+	{
+		TWeakObjectPtr<AMainCharacter> Character;
+		float CapsuleRadius;
+		float CapsuleHalfHeight;
+
+		// Ring buffer, Newest is the last written slot
+		FCombatPose Poses[MaxPoses];
+		int32 Newest = INDEX_NONE;
+		int32 Num = 0;
+	};
+
+	TArray<FPoseHistory> Histories;
+
+	float LastRecordTime = -MAX_flt;
+
+	const FPoseHistory* FindHistory(const AMainCharacter* Character) const;
+
+	// Pose interpolated at Time, false if Time is older than the history
+	static bool Rewind(const FPoseHistory& History, float Time, FCombatPose& OutPose);
+
+	static void RecordPose(FPoseHistory& History, float Time);
+};
@@ -0,0 +1,117 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "CrowdDuelBenchmarkSubsystem.generated.h"
+
+/**
+ * Headless stress scenario measuring how combat scales with the number of fighters.
+ * Spawns crowds of duelling characters, one crowd size after the other, and drives them through
+ * ignition, combo swings, evades and force pushes on a fixed script. Every crowd size is captured
+ * to its own CSV profiler file (Saved/Profiling/CSV/CrowdDuel_<N>.csv) along with the SWFL counters.
+ * Every crowd after the first has to take sabers back from the pool, the run fails and exits with an error code otherwise.
+ *
+ * SWFL /Game/Levels/Test -game -nullrhi -unattended -CrowdDuelBenchmark [-CrowdSizes=8,32,128,256] [-StageDuration=20]
+ */
+UCLASS(Config = Game)
+class SWFL_API UCrowdDuelBenchmarkSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	// Only game worlds launched with -CrowdDuelBenchmark run the benchmark
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	// Drive the crowd and move through the stages
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+	virtual TStatId GetStatId() const override;
+
+private:
+	// Character spawned for the crowd, the game mode's default pawn when unset
+	UPROPERTY(Config)
+	TSoftClassPtr<class AMainCharacter> CharacterClass;
+
+	// Crowd sizes measured one after the other
+	UPROPERTY(Config)
+	TArray<int32> CrowdSizes = { 8, 32, 128, 256 };
+
+	// Time given to a new crowd to settle before it is captured
+	UPROPERTY(Config)
+	float WarmupTime = 3.f;
+
+	// Captured time of every crowd size
+	UPROPERTY(Config)
+	float StageDuration = 20.f;
+
+	// Distance between the two fighters of a duel, and between duels
+	UPROPERTY(Config)
+	float DuelistSpacing = 150.f;
+
+	UPROPERTY(Config)
+	float DuelSpacing = 400.f;
+
+	// Average time between two scripted actions of a fighter
+	UPROPERTY(Config)
+	float ActionInterval = 0.5f;
+
+	UPROPERTY(Config)
+	bool bExitWhenDone = true;
+
+	enum class EBenchmarkState : uint8
+	{
+		WaitingForBeginPlay,
+		Warmup,
+		Capturing,
+		Teardown,
+		Done
+	};
+
+	EBenchmarkState State = EBenchmarkState::WaitingForBeginPlay;
+
+	struct FDuelist
+	{
+		TWeakObjectPtr<AMainCharacter> Character;
+		float NextActionTime;
+		int32 Step;
+	};
+
+	TArray<FDuelist> Duelists;
+
+	struct FStageResult
+	{
+		int32 CrowdSize;
+		int32 NumFrames = 0;
+		double TotalFrameMs = 0.0;
+		double TotalGameThreadMs = 0.0;
+		double MaxGameThreadMs = 0.0;
+
+		// Sabers the crowd took from the pool, new or waiting
+		int32 NumSpawned = 0;
+		int32 NumReused = 0;
+	};
+
+	TArray<FStageResult> Results;
+
+	int32 StageIndex = 0;
+	float StageStartTime = 0.f;
+
+	bool bFailed = false;
+
+	// Same script timings on every run
+	FRandomStream RandomStream;
+
+	void StartStage();
+	void SpawnCrowd(int32 CrowdSize);
+	void DriveCrowd(float Now);
+	void EndStage();
+	void DestroyCrowd();
+	void Finish();
+};
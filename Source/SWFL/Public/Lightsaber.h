@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
+#include "LightsaberBlade.h"
 #include "Lightsaber.generated.h"
 
 /*
@@ -19,8 +20,18 @@ enum class ECrystalType : uint8
 };
 */
 
+UENUM(BlueprintType)
+enum class ELightsaberLightTier : uint8
+{
+	ELT_FULL UMETA(DisplayName = "Shadow casting light"),
+	ELT_UNSHADOWED UMETA(DisplayName = "Light without shadows"),
+	ELT_OFF UMETA(DisplayName = "Emissive blade only"),
+
+	ELT_MAX UMETA(DisplayName = "DefaultMAX")
+};
+
 UCLASS()
-class SWFL_API ALightsaber : public AActor
+class SWFL_API ALightsaber : public AActor, public ILightsaberBlade
 {
 	GENERATED_BODY()
 	
@@ -28,12 +39,34 @@ public:
 	// Sets default values for this actor's properties
 	ALightsaber();
 
+	// Below this Z scale the blade is hidden in the hilt
+	static constexpr float MinVisibleScale = 0.015f;
+
+	// One interpolation step of a blade towards its target scale, shared by Tick and the blade simulation
+	static FORCEINLINE float StepBladeScale(float zScale, float zTarget, float DeltaTime, float InterpSpeed, float DefaultIntensity, float& OutLightIntensity, bool& bOutVisible)
+	{
+		const float Scale = FMath::FInterpTo(zScale, zTarget, DeltaTime, InterpSpeed);
+
+		OutLightIntensity = Scale * DefaultIntensity;
+		bOutVisible = Scale > MinVisibleScale;
+
+		return Scale;
+	}
+
+	// Sweep a blade from its last pose to the current one, one pose every MaxSubstepAngle degrees or MaxSubstepDistance units
+	// of travel, pawns touched are added to OutHitActors, shared with the lightweight saber component
+	static void SweepBladeArc(const UWorld* World, const FVector& PrevBase, const FVector& PrevTip, const FVector& Base, const FVector& Tip, float Radius,
+		float MaxSubstepAngle, float MaxSubstepDistance, int32 MaxSubsteps, const FCollisionQueryParams& CollisionParams, TArray<AActor*>& OutHitActors);
+
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
-	UFUNCTION()
-	void OnBladeOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult);
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	void OnBladeHit(AActor* OtherActor);
 
 	// Activate/deactivate collision for blade
 	UFUNCTION(BlueprintCallable)
@@ -41,7 +74,8 @@ protected:
 	UFUNCTION(BlueprintCallable)
 	void DeactivateBladeCollision();
 
-	void DoDamage(class AMainCharacter* Victim);
+	// Sweep the blade from last frame's Base/Tip to the current ones, sub-stepped by how far it turned
+	void SweepBlade();
 
 private:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Weapon | Tweaks", meta = (AllowPrivateAccess = "true"))
@@ -84,6 +118,10 @@ private:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Weapon | VFX", meta = (AllowPrivateAccess = "true"))
 	UParticleSystem* ExtinguishVFX;
 
+	// Sparks where this blade starts touching another one
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Weapon | VFX", meta = (AllowPrivateAccess = "true"))
+	UParticleSystem* ClashVFX;
+
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Weapon | VFX", meta = (AllowPrivateAccess = "true"))
 	class UParticleSystemComponent* Beam;
 
@@ -111,18 +149,158 @@ private:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Weapon | Tweaks", meta = (AllowPrivateAccess = "true"))
 	class UBoxComponent* BladeCollision;
 
+	// Trace the blade synchronously when it belongs to the local player, instead of using last frame's async result
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Weapon | Tweaks", meta = (AllowPrivateAccess = "true"))
+	bool bSyncTraceForLocalPlayer;
+
+	UPROPERTY(Transient)
+	class ULightsaberTraceSubsystem* TraceSubsystem;
+
+	UPROPERTY(Transient)
+	class ULightsaberImpactSubsystem* ImpactSubsystem;
+
+	UPROPERTY(Transient)
+	class ULightsaberBurnMarkSubsystem* BurnMarkSubsystem;
+
+	UPROPERTY(Transient)
+	class UCombatFXSubsystem* CombatFXSubsystem;
+
+	bool ShouldUseSyncTrace() const;
+
+	// Blade scale on Z axis as simulated, the component is only updated when it differs by more than BladeScaleTolerance
+	float zBladeScale;
+
+	// Visibility last pushed to light, blade and beam
+	bool bBladeVisible;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Weapon | Tweaks", meta = (AllowPrivateAccess = "true"))
+	float BladeScaleTolerance;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Weapon | Tweaks", meta = (AllowPrivateAccess = "true"))
+	float LightIntensityTolerance;
+
+	// Component updates sent to the render thread and the ones skipped because nothing changed
+	UPROPERTY(VisibleInstanceOnly, Transient, BlueprintReadOnly, Category = "Weapon | Stats", meta = (AllowPrivateAccess = "true"))
+	int32 PushedComponentUpdates;
+
+	UPROPERTY(VisibleInstanceOnly, Transient, BlueprintReadOnly, Category = "Weapon | Stats", meta = (AllowPrivateAccess = "true"))
+	int32 SkippedComponentUpdates;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Weapon | Tweaks", meta = (AllowPrivateAccess = "true"))
+	bool bIsBladeCollisionActive;
+
+	// Radius of the sphere swept along the blade
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Weapon | Tweaks", meta = (AllowPrivateAccess = "true"))
+	float BladeSweepRadius;
+
+	// Largest turn in degrees and travel in units of the blade between two swept poses
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Weapon | Tweaks", meta = (AllowPrivateAccess = "true"))
+	float MaxSubstepAngle;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Weapon | Tweaks", meta = (AllowPrivateAccess = "true"))
+	float MaxSubstepDistance;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Weapon | Tweaks", meta = (AllowPrivateAccess = "true"))
+	int32 MaxSubsteps;
+
+	// Blade pose at the end of the last sweep
+	FVector PrevSweepBase;
+	FVector PrevSweepTip;
+
+	// Actors already hit since the blade collision was activated
+	TArray<TWeakObjectPtr<AActor>> SweptActors;
+
+	// Light tier given by the light budget
+	UPROPERTY(VisibleInstanceOnly, Transient, BlueprintReadOnly, Category = "Weapon | VFX", meta = (AllowPrivateAccess = "true"))
+	ELightsaberLightTier LightTier;
+
+	// Whether the light casts shadows when it is in the full tier, as set up on the component
+	bool bLightCastsShadows;
+
+	UPROPERTY(Transient)
+	class ULightsaberLightBudgetSubsystem* LightBudgetSubsystem;
+
+	UPROPERTY(Transient)
+	class ULightsaberAudioSubsystem* AudioSubsystem;
+
+	UPROPERTY(Transient)
+	class ULightsaberSimulationSubsystem* SimulationSubsystem;
+
+	// Waiting in the saber pool
+	bool bIsPooled;
+
+	// Written by the server, clients follow its ignition and blade length
+	UPROPERTY(ReplicatedUsing = OnRep_NetState)
+	FLightsaberNetState NetState;
+
+	UFUNCTION()
+	void OnRep_NetState();
+
+	// Quantize the ignition and blade length on the server, replicated only if the quantized state changed
+	void UpdateNetState(float BladeLength);
+
+	// Resume blade updates, through the blade simulation or the actor tick
+	void WakeUp();
+
+	virtual void ApplyBladeStep(float zCurrentScale, bool bVisible, float LightIntensity) override;
+	virtual bool IsBladeSettled() const override;
+
+	// Push blade state to components only when it has changed
+	void UpdateBladeVisibility(bool bVisible);
+	void UpdateBladeScale(float zScale);
+	void UpdateLightIntensity(float Intensity);
+
 public:	
 	// Called every frame
 	virtual void Tick(float DeltaTime) override;
 
-	void IgniteLightsaber();
-	void ExtinguishLightsaber();
+	// Attach to a character's mesh socket and tick after that mesh
+	void AttachToMesh(class USkeletalMeshComponent* Mesh, FName SocketName);
+	void DetachFromMesh();
+
+	// Called by the saber pool, a pooled saber is sheathed at once without effects, detached, hidden and unowned
+	void ReturnToPool();
+	void LeavePool(AActor* NewOwner);
+	FORCEINLINE bool IsPooled() const { return bIsPooled; }
+
+	virtual void IgniteLightsaber() override;
+	virtual void ExtinguishLightsaber() override;
 
 	void SpawnHiltVFX(UParticleSystem* VFX, UStaticMeshComponent* Object, FName ObjectSocket, FVector VFXLocation, FRotator VFXRotation, FVector VFXScale);
 
 	bool RayCast(float& zCurrentScaleLimit, float& zCollisionScale);
 
-	FORCEINLINE bool GetIsIgnited() const { return bIsIgnited; }
+	virtual void DoDamage(class AMainCharacter* Victim) override;
+
+	// Sparks and burn mark of the blade touching geometry at Location
+	void PlayImpactFX(const FVector& Location, const FVector& Normal);
+
+	// Sparks of this blade starting to touch another one at Location
+	void PlayClashFX(const FVector& Location, const FVector& Normal);
+
+	virtual bool GetIsIgnited() const override { return bIsIgnited; }
+	virtual bool IsBladeVisible() const override { return bBladeVisible; }
+
+	virtual void SetBladeCollisionActive(bool bActive) override;
+
+	virtual void GetBladeSegment(FVector& OutBase, FVector& OutTip) const override;
+	virtual float GetBladeRadius() const override { return BladeSweepRadius; }
+
+	virtual float GetBladeScaleTarget() const override { return zScaleTarget; }
+	virtual void SetBladeScaleTarget(float ScaleTarget) override;
+	virtual float GetBladeInterpSpeed() const override { return zInterpSpeed; }
+	virtual float GetBladeScale() const override { return zBladeScale; }
+	virtual float GetDefaultLightIntensity() const override { return DefaultLightIntensity; }
+
+	FORCEINLINE UPointLightComponent* GetLight() const { return Light; }
+
+	FORCEINLINE ELightsaberLightTier GetLightTier() const { return LightTier; }
+	void SetLightTier(ELightsaberLightTier Tier);
 
 	FORCEINLINE UParticleSystemComponent* GetTrail() const { return Trail; }
+
+	FORCEINLINE UStaticMeshComponent* GetHilt() const { return Hilt; }
+	FORCEINLINE FName GetHiltSocket() const { return HiltSocket; }
+
+	FORCEINLINE UAudioComponent* GetIdleSound() const { return IdleSound; }
 };
@@ -0,0 +1,97 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "LightsaberAudioSubsystem.generated.h"
+
+/**
+ * Voice budget for combat sounds.
+ * Idle hums of sabers close to each other share the voice of the one nearest to the listener,
+ * hums too far away or over budget are stopped until they matter again.
+ * Hit sounds play on a pool of reusable one-shot components, capped per frame and per area.
+ */
+UCLASS(Config = Game)
+class SWFL_API ULightsaberAudioSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	// Start/stop the idle hum of an ignited saber
+	void StartHum(class ALightsaber* Lightsaber);
+	void StopHum(ALightsaber* Lightsaber);
+
+	// Play a hit sound from the pool, returns false if it was dropped by the voice caps
+	bool PlayHitSound(class USoundBase* Sound, const FVector& Location);
+
+	virtual void Deinitialize() override;
+
+	// Assign hum voices
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+	virtual TStatId GetStatId() const override;
+
+	FORCEINLINE int32 GetNumHumVoices() const { return NumHumVoices; }
+
+private:
+	// Hums further than this from the listener are virtualized
+	UPROPERTY(Config)
+	float MaxHumDistance = 2500.f;
+
+	// Sabers within this radius of a playing hum share its voice
+	UPROPERTY(Config)
+	float HumShareRadius = 200.f;
+
+	UPROPERTY(Config)
+	int32 MaxHumVoices = 8;
+
+	UPROPERTY(Config)
+	float HumFadeTime = 0.1f;
+
+	// Size of the hit sound pool
+	UPROPERTY(Config)
+	int32 MaxHitSoundVoices = 16;
+
+	UPROPERTY(Config)
+	int32 MaxHitSoundsPerFrame = 4;
+
+	// No more than MaxHitSoundsPerArea hit sounds play within HitSoundAreaRadius of each other
+	UPROPERTY(Config)
+	float HitSoundAreaRadius = 300.f;
+
+	UPROPERTY(Config)
+	int32 MaxHitSoundsPerArea = 2;
+
+	// Seconds between two hum voice assignments
+	UPROPERTY(Config)
+	float UpdateInterval = 0.1f;
+
+	float TimeSinceUpdate = 0.f;
+
+	TArray<TWeakObjectPtr<ALightsaber>> HummingLightsabers;
+
+	struct FHumCandidate
+	{
+		ALightsaber* Lightsaber;
+		FVector Location;
+		float DistanceSquared;
+		bool bAssigned;
+	};
+
+	// Kept between updates to avoid reallocating
+	TArray<FHumCandidate> HumCandidates;
+
+	int32 NumHumVoices = 0;
+
+	UPROPERTY(Transient)
+	TArray<class UAudioComponent*> HitSoundPool;
+
+	uint64 HitSoundFrame = 0;
+	int32 HitSoundsThisFrame = 0;
+
+	void SetHumPlaying(ALightsaber* Lightsaber, bool bPlaying);
+};
@@ -0,0 +1,120 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Interface.h"
+#include "LightsaberBlade.generated.h"
+
+class ILightsaberBlade;
+
+// Replicated state of a saber, quantized to 9 bits and only sent when it changes
+USTRUCT()
+struct FLightsaberNetState
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	bool bIgnited = false;
+
+	// Collision-clamped blade length as a fraction of the full blade, 255 is a full blade
+	UPROPERTY()
+	uint8 BladeLength = 0;
+
+	// State of a blade BladeLength long out of MaxScale, on the server
+	static FLightsaberNetState Quantize(bool bInIgnited, float InBladeLength, float MaxScale);
+
+	// Follow the server's state on a client, ignition effects only play when the state flips
+	void Apply(ILightsaberBlade& Blade, float MaxScale) const;
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess)
+	{
+		uint8 Ignited = bIgnited ? 1 : 0;
+		Ar.SerializeBits(&Ignited, 1);
+		bIgnited = Ignited != 0;
+
+		Ar << BladeLength;
+
+		bOutSuccess = true;
+		return true;
+	}
+
+	bool operator==(const FLightsaberNetState& Other) const
+	{
+		return bIgnited == Other.bIgnited && BladeLength == Other.BladeLength;
+	}
+};
+
+template<>
+struct TStructOpsTypeTraits<FLightsaberNetState> : public TStructOpsTypeTraitsBase2<FLightsaberNetState>
+{
+	enum
+	{
+		WithNetSerializer = true,
+		WithIdenticalViaEquality = true
+	};
+};
+
+UINTERFACE(meta = (CannotImplementInterfaceInBlueprint))
+class ULightsaberBlade : public UInterface
+{
+	GENERATED_BODY()
+};
+
+/**
+ * A blade as the wielder, the blade simulation, the batched traces and the damage resolve see it,
+ * implemented by the saber actor and by the lightweight saber component.
+ */
+class SWFL_API ILightsaberBlade
+{
+	GENERATED_BODY()
+
+	// Keeps the slot of awake blades
+	friend class ULightsaberSimulationSubsystem;
+
+public:
+	virtual void IgniteLightsaber() = 0;
+	virtual void ExtinguishLightsaber() = 0;
+	virtual bool GetIsIgnited() const = 0;
+	virtual bool IsBladeVisible() const = 0;
+
+	// Sweep the blade for hits while an attack is active
+	virtual void SetBladeCollisionActive(bool bActive) = 0;
+
+	// Blade as a capsule between its Base and Tip sockets
+	virtual void GetBladeSegment(FVector& OutBase, FVector& OutTip) const = 0;
+	virtual float GetBladeRadius() const = 0;
+
+	// Play the hit sound and effect on Victim, called by the damage subsystem once per victim per frame
+	virtual void DoDamage(class AMainCharacter* Victim) = 0;
+
+	// Scale the blade interpolates towards, set from the server's state on clients
+	virtual float GetBladeScaleTarget() const = 0;
+	virtual void SetBladeScaleTarget(float ScaleTarget) = 0;
+
+	// Blade state the simulation reads when the blade wakes up and after every step
+	virtual float GetBladeInterpSpeed() const = 0;
+	virtual float GetBladeScale() const = 0;
+	virtual float GetDefaultLightIntensity() const = 0;
+
+	// Game thread part of a blade update once the new scale is known: visibility, collision clamp, components and sweeps
+	virtual void ApplyBladeStep(float zCurrentScale, bool bVisible, float LightIntensity) = 0;
+
+	// Extinguished, retracted and not sweeping, nothing left to update
+	virtual bool IsBladeSettled() const = 0;
+
+	// Called by the trace subsystem when the blade trace queued last frame has completed
+	void ReceiveBladeTrace(bool bIsHit, const FHitResult& OutHit)
+	{
+		bLastBladeTraceHit = bIsHit;
+		LastBladeTraceHit = OutHit;
+	}
+
+protected:
+	// Slot in the blade simulation while awake
+	int32 SimulationIndex = INDEX_NONE;
+
+	// Result of the last async blade trace
+	bool bLastBladeTraceHit = false;
+	FHitResult LastBladeTraceHit;
+};
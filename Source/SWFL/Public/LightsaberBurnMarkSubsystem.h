@@ -0,0 +1,98 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "LightsaberBurnMarkSubsystem.generated.h"
+
+/**
+ * Burn marks left by blades dragged along geometry.
+ * Decal components come from a fixed-size ring buffer, the oldest mark is reused once the pool is full.
+ * Consecutive contacts of one source are merged into a single decal stretched along the drag.
+ */
+UCLASS(Config = Game)
+class SWFL_API ULightsaberBurnMarkSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	// Report a contact of Source at Location, starts a new mark or stretches the current one
+	void AddBurnMark(const AActor* Source, class UMaterialInterface* Material, const FVector& DecalSize, const FVector& Location, const FVector& Normal);
+
+	virtual void Deinitialize() override;
+
+	// Hide the marks which have outlived their lifetime
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+	virtual TStatId GetStatId() const override;
+
+	FORCEINLINE int32 GetNumLiveBurnMarks() const { return NumLiveBurnMarks; }
+
+private:
+	// Size of the decal pool, memory and draw cost of burn marks never go above it
+	UPROPERTY(Config)
+	int32 MaxBurnMarks = 64;
+
+	// How long a mark stays visible after the last contact that touched it
+	UPROPERTY(Config)
+	float BurnMarkLifetime = 2.f;
+
+	// Contacts closer than this to the end of the current stroke and within MergeTime stretch it
+	UPROPERTY(Config)
+	float MergeDistance = 30.f;
+
+	UPROPERTY(Config)
+	float MergeTime = 0.15f;
+
+	// A stroke longer than this starts a new decal
+	UPROPERTY(Config)
+	float MaxStrokeLength = 150.f;
+
+	// Contacts moving less than this only refresh the stroke's lifetime
+	UPROPERTY(Config)
+	float MinStrokeStep = 2.f;
+
+	// Surfaces must face the same way within this cosine to share a stroke
+	UPROPERTY(Config)
+	float MinNormalDot = 0.9f;
+
+	UPROPERTY(Transient)
+	TArray<class UDecalComponent*> Decals;
+
+	struct FBurnMarkSlot
+	{
+		float LastTouchTime = 0.f;
+		uint32 Generation = 0;
+		bool bLive = false;
+	};
+
+	// Parallel to Decals
+	TArray<FBurnMarkSlot> Slots;
+
+	// Next slot of the ring buffer
+	int32 NextSlot = 0;
+
+	struct FBurnStroke
+	{
+		TWeakObjectPtr<const AActor> Source;
+		int32 Slot;
+		uint32 Generation;
+		FVector StartPoint;
+		FVector EndPoint;
+		FVector Normal;
+		FVector DecalSize;
+		float LastTime;
+	};
+
+	// Current stroke of every source that burned something recently
+	TArray<FBurnStroke> Strokes;
+
+	int32 NumLiveBurnMarks = 0;
+
+	int32 AcquireSlot(class UMaterialInterface* Material);
+	void PlaceDecal(const FBurnStroke& Stroke);
+};
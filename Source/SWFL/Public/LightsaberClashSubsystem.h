@@ -0,0 +1,67 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "LightsaberClashSubsystem.generated.h"
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_FourParams(FOnLightsaberClash, class ALightsaber*, LightsaberA, ALightsaber*, LightsaberB, FVector, ContactPoint, FVector, RelativeVelocity);
+
+/**
+ * Detects blades of different owners crossing each other.
+ * Every visible blade is a capsule between its Base and Tip sockets. Candidate pairs come from a sort and sweep
+ * broadphase on X, then the closest points between segments are computed four pairs at a time with vector registers.
+ * A clash is raised once when two blades start touching.
+ */
+UCLASS()
+class SWFL_API ULightsaberClashSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	// Contact point is halfway between the closest points of both blades, velocity is A's relative to B's at those points
+	UPROPERTY(BlueprintAssignable, Category = "Combat")
+	FOnLightsaberClash OnClash;
+
+	// Look for new clashes among the blades updated this frame
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+	virtual TStatId GetStatId() const override;
+
+	FORCEINLINE int32 GetNumCandidatePairs() const { return CandidatePairs.Num(); }
+
+private:
+	struct FBladeProxy
+	{
+		ALightsaber* Lightsaber;
+		const AActor* Owner;
+		FVector Base;
+		FVector Tip;
+		FVector BaseVelocity;
+		FVector TipVelocity;
+		FBox Bounds;
+		float Radius;
+	};
+
+	struct FBladePose
+	{
+		FVector Base;
+		FVector Tip;
+	};
+
+	// Kept between frames to avoid reallocating
+	TArray<FBladeProxy> Proxies;
+	TArray<TPair<int32, int32>> CandidatePairs;
+
+	// Blade poses of last frame, for velocities
+	TMap<TWeakObjectPtr<ALightsaber>, FBladePose> LastPoses;
+	TMap<TWeakObjectPtr<ALightsaber>, FBladePose> CurrentPoses;
+
+	// Pairs touching last frame and this frame, keyed by both sabers' unique ids
+	TSet<uint64> LastContacts;
+	TSet<uint64> CurrentContacts;
+};
@@ -0,0 +1,147 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/StaticMeshComponent.h"
+#include "LightsaberBlade.h"
+#include "LightsaberComponent.generated.h"
+
+/**
+ * Lightweight saber for background characters, the blade mesh itself attached to the wielder's hand socket.
+ * Ignites, extinguishes, clamps its blade against geometry and sweeps it for hits like ALightsaber, without an actor,
+ * hilt, effects or sounds, and with a point light only if bUseLight is set.
+ * Has no tick of its own: the blade simulation steps it with the saber actors while it is ignited, moving or sweeping,
+ * and its contact trace goes through the batched async traces.
+ */
+UCLASS(ClassGroup = (SWFL), meta = (BlueprintSpawnableComponent))
+class SWFL_API ULightsaberComponent : public UStaticMeshComponent, public ILightsaberBlade
+{
+	GENERATED_BODY()
+
+public:
+	ULightsaberComponent();
+
+	// Only reached when there is no blade simulation
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	virtual void IgniteLightsaber() override;
+	virtual void ExtinguishLightsaber() override;
+
+	// Activate/deactivate collision for blade
+	UFUNCTION(BlueprintCallable)
+	void ActivateBladeCollision();
+	UFUNCTION(BlueprintCallable)
+	void DeactivateBladeCollision();
+
+	virtual void DoDamage(class AMainCharacter* Victim) override;
+
+	virtual bool GetIsIgnited() const override { return bIsIgnited; }
+	virtual bool IsBladeVisible() const override { return bBladeVisible; }
+
+	virtual void SetBladeCollisionActive(bool bActive) override;
+
+	virtual void GetBladeSegment(FVector& OutBase, FVector& OutTip) const override;
+	virtual float GetBladeRadius() const override { return BladeSweepRadius; }
+
+	virtual float GetBladeScaleTarget() const override { return zScaleTarget; }
+	virtual void SetBladeScaleTarget(float ScaleTarget) override;
+	virtual float GetBladeInterpSpeed() const override { return zInterpSpeed; }
+	virtual float GetBladeScale() const override { return zBladeScale; }
+	virtual float GetDefaultLightIntensity() const override { return DefaultLightIntensity; }
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void OnComponentDestroyed(bool bDestroyingHierarchy) override;
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+private:
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Weapon | Tweaks", meta = (AllowPrivateAccess = "true"))
+	float zMaxScale;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Weapon | Tweaks", meta = (AllowPrivateAccess = "true"))
+	float engineBladeScale;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Weapon | Tweaks", meta = (AllowPrivateAccess = "true"))
+	FName BaseBladeSocket;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Weapon | Tweaks", meta = (AllowPrivateAccess = "true"))
+	FName TipBladeSocket;
+
+	// Radius of the sphere swept along the blade
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Weapon | Tweaks", meta = (AllowPrivateAccess = "true"))
+	float BladeSweepRadius;
+
+	// Largest turn in degrees and travel in units of the blade between two swept poses
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Weapon | Tweaks", meta = (AllowPrivateAccess = "true"))
+	float MaxSubstepAngle;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Weapon | Tweaks", meta = (AllowPrivateAccess = "true"))
+	float MaxSubstepDistance;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Weapon | Tweaks", meta = (AllowPrivateAccess = "true"))
+	int32 MaxSubsteps;
+
+	// Unshadowed light along the blade, created at begin play
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Weapon | VFX", meta = (AllowPrivateAccess = "true"))
+	bool bUseLight;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Weapon | VFX", meta = (AllowPrivateAccess = "true"))
+	FLinearColor LightColor;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Weapon | VFX", meta = (AllowPrivateAccess = "true"))
+	float DefaultLightIntensity;
+
+	UPROPERTY(Transient)
+	class UPointLightComponent* Light;
+
+	UPROPERTY(Transient)
+	class ULightsaberSimulationSubsystem* SimulationSubsystem;
+
+	UPROPERTY(Transient)
+	class ULightsaberTraceSubsystem* TraceSubsystem;
+
+	bool bIsIgnited;
+	bool bBladeVisible;
+	bool bIsBladeCollisionActive;
+
+	float zScaleTarget;
+	float zInterpSpeed;
+
+	// Blade scale on Z axis as simulated
+	float zBladeScale;
+
+	// Blade pose at the end of the last sweep
+	FVector PrevSweepBase;
+	FVector PrevSweepTip;
+
+	// Actors already hit since the blade collision was activated
+	TArray<TWeakObjectPtr<AActor>> SweptActors;
+
+	// Written by the server, clients follow its ignition and blade length
+	UPROPERTY(ReplicatedUsing = OnRep_NetState)
+	FLightsaberNetState NetState;
+
+	UFUNCTION()
+	void OnRep_NetState();
+
+	void UpdateNetState(float BladeLength);
+
+	// Join the blade simulation, or tick without one
+	void WakeUp();
+
+	virtual void ApplyBladeStep(float zCurrentScale, bool bVisible, float LightIntensity) override;
+	virtual bool IsBladeSettled() const override;
+
+	// Trace the blade against geometry, OutCollisionScale is the blade scale up to the hit
+	bool RayCast(float& OutCollisionScale);
+
+	// Hits are looked for on the server, and on the owning client of a player who claims them
+	bool ShouldSweepBlade() const;
+
+	void SweepBlade();
+	void OnBladeHit(AActor* OtherActor);
+
+	void SetBladeVisible(bool bVisible);
+};
@@ -0,0 +1,55 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "UObject/WeakInterfacePtr.h"
+#include "LightsaberBlade.h"
+#include "LightsaberDamageSubsystem.generated.h"
+
+/**
+ * Collects the blade hits of a frame and resolves them once every actor has ticked.
+ * Each attacker's swing hits a victim at most once, whichever blade lands it,
+ * and each victim gets a single hit sound and effect per frame.
+ */
+UCLASS()
+class SWFL_API ULightsaberDamageSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	// Register a hit of Blade on Victim during the attacker's swing, returns false if this swing already hit Victim
+	bool QueueHit(ILightsaberBlade* Blade, AActor* Attacker, int32 SwingId, class AMainCharacter* Victim);
+
+	// Resolve the hits queued this frame
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+	virtual TStatId GetStatId() const override;
+
+private:
+	struct FSwingHits
+	{
+		int32 SwingId = INDEX_NONE;
+		TArray<TWeakObjectPtr<AActor>> Victims;
+	};
+
+	// Victims of the current swing of every attacker
+	TMap<TWeakObjectPtr<AActor>, FSwingHits> SwingHits;
+
+	struct FPendingHit
+	{
+		TWeakInterfacePtr<ILightsaberBlade> Blade;
+		TWeakObjectPtr<AMainCharacter> Victim;
+
+		// Sort keys, so hits resolve in the same order whatever order sabers ticked in
+		uint32 VictimId;
+		uint32 AttackerId;
+		uint32 LightsaberId;
+	};
+
+	TArray<FPendingHit> PendingHits;
+};
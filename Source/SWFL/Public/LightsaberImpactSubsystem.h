@@ -0,0 +1,76 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "LightsaberImpactSubsystem.generated.h"
+
+/**
+ * Spawns the sparks of blades touching geometry.
+ * Impacts of one source and effect that stay close in space and time share a single emitter which follows the contact point,
+ * new emitters are rate-limited per source and effect and capped per frame for the whole world.
+ */
+UCLASS(Config = Game)
+class SWFL_API ULightsaberImpactSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	// Report a contact of Source at Location, spawns or moves its impact effect
+	void AddImpact(const AActor* Source, class UParticleSystem* VFX, const FVector& Location, const FRotator& Rotation, const FVector& Scale);
+
+	virtual void Deinitialize() override;
+
+	// Release the effects of finished contacts
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+	virtual TStatId GetStatId() const override;
+
+	FORCEINLINE int32 GetNumSpawned() const { return NumSpawned; }
+	FORCEINLINE int32 GetNumMerged() const { return NumMerged; }
+	FORCEINLINE int32 GetNumDropped() const { return NumDropped; }
+
+private:
+	// Impacts closer than this to the last one of the same source are merged into its effect
+	UPROPERTY(Config)
+	float MergeDistance = 25.f;
+
+	// A contact ends when its source has not reported an impact for this long
+	UPROPERTY(Config)
+	float MergeTime = 0.15f;
+
+	// Minimum time between two effects started by one source with the same effect
+	UPROPERTY(Config)
+	float MinImpactInterval = 0.05f;
+
+	// New emitters allowed per frame in the whole world
+	UPROPERTY(Config)
+	int32 MaxNewEmittersPerFrame = 8;
+
+	struct FImpactStream
+	{
+		TWeakObjectPtr<const AActor> Source;
+		TWeakObjectPtr<class UParticleSystemComponent> Component;
+		UParticleSystem* VFX;
+		FVector LastLocation;
+		float LastImpactTime;
+		float LastTriggerTime;
+	};
+
+	// One entry per source and effect currently in contact
+	TArray<FImpactStream> Streams;
+
+	void ReleaseStream(FImpactStream& Stream);
+
+	uint64 BudgetFrame = 0;
+	int32 NewEmittersThisFrame = 0;
+
+	// Totals since the world started
+	int32 NumSpawned = 0;
+	int32 NumMerged = 0;
+	int32 NumDropped = 0;
+};
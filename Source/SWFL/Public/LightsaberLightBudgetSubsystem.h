@@ -0,0 +1,68 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "LightsaberLightBudgetSubsystem.generated.h"
+
+/**
+ * Keeps the number of dynamic saber lights within budget.
+ * Ignited sabers are ranked by the screen size of their light, scaled by the importance of their owner.
+ * The top ones keep a full shadow casting light, the next tier loses its shadows and the rest rely on the emissive blade alone.
+ */
+UCLASS(Config = Game)
+class SWFL_API ULightsaberLightBudgetSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	void RegisterLightsaber(class ALightsaber* Lightsaber);
+	void UnregisterLightsaber(ALightsaber* Lightsaber);
+
+	// Rank the lights and assign their tiers
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+	virtual TStatId GetStatId() const override;
+
+private:
+	// Lights keeping their shadows
+	UPROPERTY(Config)
+	int32 MaxFullLights = 4;
+
+	// Lights without shadows after the full ones
+	UPROPERTY(Config)
+	int32 MaxUnshadowedLights = 12;
+
+	// Score bonus per tier a light already holds, so lights near a tier boundary do not pop
+	UPROPERTY(Config)
+	float Hysteresis = 0.25f;
+
+	// Score multiplier for the sabers of locally controlled players
+	UPROPERTY(Config)
+	float LocalPlayerImportance = 4.f;
+
+	// Score multiplier for lights behind the camera, they only light what is in front of it through their radius
+	UPROPERTY(Config)
+	float BehindCameraFactor = 0.25f;
+
+	// Seconds between two rankings
+	UPROPERTY(Config)
+	float UpdateInterval = 0.1f;
+
+	float TimeSinceUpdate = 0.f;
+
+	TArray<TWeakObjectPtr<ALightsaber>> Lightsabers;
+
+	struct FRankedLight
+	{
+		ALightsaber* Lightsaber;
+		float Score;
+	};
+
+	// Kept between updates to avoid reallocating
+	TArray<FRankedLight> RankedLights;
+};
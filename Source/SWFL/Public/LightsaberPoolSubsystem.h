@@ -0,0 +1,83 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "LightsaberPoolSubsystem.generated.h"
+
+// Number of sabers of a class spawned ahead when the level starts
+USTRUCT()
+struct FLightsaberPoolPrewarm
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TSoftClassPtr<class ALightsaber> Class;
+
+	UPROPERTY()
+	int32 Count = 0;
+};
+
+USTRUCT()
+struct FLightsaberPoolList
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<ALightsaber*> Lightsabers;
+};
+
+/**
+ * Keeps sheathed, hidden and unowned sabers per class so characters do not construct theirs when they spawn.
+ * Sabers listed in PrewarmedLightsabers are spawned when the level starts, the default pawn's sabers when the list is empty.
+ * Acquiring from an empty pool spawns a new one.
+ * Only the server pools, clients get the sabers through replication.
+ */
+UCLASS(Config = Game)
+class SWFL_API ULightsaberPoolSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+
+	// Spawn sabers of Class until Count of them are waiting in the pool
+	void Prewarm(TSubclassOf<ALightsaber> Class, int32 Count);
+
+	// Hand a saber of Class to NewOwner, taken from the pool if one is waiting
+	ALightsaber* AcquireLightsaber(TSubclassOf<ALightsaber> Class, AActor* NewOwner);
+
+	// Take a saber back, sheathed and detached, it is destroyed if its class already has enough waiting
+	void ReleaseLightsaber(ALightsaber* Lightsaber);
+
+	FORCEINLINE int32 GetNumSpawned() const { return NumSpawned; }
+	FORCEINLINE int32 GetNumReused() const { return NumReused; }
+
+private:
+	ALightsaber* SpawnLightsaber(TSubclassOf<ALightsaber> Class, AActor* NewOwner);
+
+	// Let the replication graph replicate the saber with its new owner
+	void UpdateDependentOwner(ALightsaber* Lightsaber, AActor* OldOwner, AActor* NewOwner);
+
+	UPROPERTY(Config)
+	TArray<FLightsaberPoolPrewarm> PrewarmedLightsabers;
+
+	// Characters the default pawn's sabers are prewarmed for when PrewarmedLightsabers is empty
+	UPROPERTY(Config)
+	int32 DefaultPawnPrewarmCount = 8;
+
+	void PrewarmDefaultPawn(UWorld& InWorld);
+
+	// Sabers kept waiting per class, more released ones are destroyed
+	UPROPERTY(Config)
+	int32 MaxPooledPerClass = 64;
+
+	UPROPERTY(Transient)
+	TMap<UClass*, FLightsaberPoolList> FreeLightsabers;
+
+	// Totals since the world started
+	int32 NumSpawned = 0;
+	int32 NumReused = 0;
+};
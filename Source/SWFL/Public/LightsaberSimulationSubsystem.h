@@ -0,0 +1,79 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineBaseTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "LightsaberSimulationSubsystem.generated.h"
+
+USTRUCT()
+struct FLightsaberSimulationTickFunction : public FTickFunction
+{
+	GENERATED_BODY()
+
+	class ULightsaberSimulationSubsystem* Simulation = nullptr;
+
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override;
+};
+
+template<>
+struct TStructOpsTypeTraits<FLightsaberSimulationTickFunction> : public TStructOpsTypeTraitsBase2<FLightsaberSimulationTickFunction>
+{
+	enum
+	{
+		WithCopy = false
+	};
+};
+
+/**
+ * Updates the blades of every awake lightsaber in one place instead of one actor tick per saber.
+ * Blade state is kept in structure-of-arrays form, interpolated for all sabers in a ParallelFor pass,
+ * then applied to the components in a single game thread write-back.
+ * Sabers join when they wake up (ignite, extinguish, blade collision) and leave once their blade has settled.
+ * Saber actors and lightweight blade components are simulated alike, through their ILightsaberBlade.
+ */
+UCLASS(Config = Game)
+class SWFL_API ULightsaberSimulationSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	// Add the blade to the simulation, or refresh its target and speed if it is already awake
+	void WakeLightsaber(class ILightsaberBlade* Blade);
+	void SleepLightsaber(ILightsaberBlade* Blade);
+
+	// Interpolate every awake blade and write the results back
+	void Simulate(float DeltaTime);
+
+	FORCEINLINE int32 GetNumAwakeLightsabers() const { return Blades.Num(); }
+	FORCEINLINE const TArray<ILightsaberBlade*>& GetAwakeBlades() const { return Blades; }
+
+private:
+	// Blades interpolated per ParallelFor task
+	UPROPERTY(Config)
+	int32 BatchSize = 64;
+
+	// Runs after physics, when the owners' meshes have their final pose for the frame.
+	// The tick group alone orders it after the meshes, sabers add no per-mesh prerequisites
+	FLightsaberSimulationTickFunction SimulationTick;
+
+	// Awake blades, the arrays below are indexed the same way. Blades leave in their EndPlay, before they can be collected
+	TArray<ILightsaberBlade*> Blades;
+
+	TArray<float> ScaleTargets;
+	TArray<float> InterpSpeeds;
+	TArray<float> BladeScales;
+	TArray<float> DefaultLightIntensities;
+
+	// Kernel outputs
+	TArray<float> LightIntensities;
+	TArray<uint8> VisibleFlags;
+
+	// Slot for a new saber, with the tick enabled
+	int32 AddSlot();
+	void RemoveAt(int32 Index);
+};
@@ -0,0 +1,53 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "WorldCollision.h"
+#include "UObject/WeakInterfacePtr.h"
+#include "LightsaberBlade.h"
+#include "LightsaberTraceSubsystem.generated.h"
+
+/**
+ * Gathers the Base->Tip traces requested by lightsaber blades during a frame and submits them together as async traces.
+ * Results are handed back to each blade before actors tick on the following frame.
+ */
+UCLASS()
+class SWFL_API ULightsaberTraceSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	// Queue a blade trace for this frame's batch
+	void RequestBladeTrace(ILightsaberBlade* Blade, const FVector& StartPoint, const FVector& EndPoint, const FCollisionQueryParams& CollisionParams);
+
+	// Submit every trace queued this frame
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+	virtual TStatId GetStatId() const override;
+
+private:
+	void OnBladeTraceDone(const FTraceHandle& TraceHandle, FTraceDatum& TraceData);
+
+	struct FBladeTraceRequest
+	{
+		TWeakInterfacePtr<ILightsaberBlade> Blade;
+		FVector StartPoint;
+		FVector EndPoint;
+		FCollisionQueryParams CollisionParams;
+	};
+
+	// Traces requested during the current frame
+	TArray<FBladeTraceRequest> PendingRequests;
+
+	// Blades of the last submitted batch, indexed by the trace user data
+	TArray<TWeakInterfacePtr<ILightsaberBlade>> InFlightBlades;
+
+	FTraceDelegate BladeTraceDelegate;
+};
@@ -4,21 +4,77 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
+#include "Engine/NetSerialization.h"
+#include "CombatFXSubsystem.h"
 #include "MainCharacter.generated.h"
 
+class ILightsaberBlade;
+
+UENUM(BlueprintType)
+enum class EBufferedAction : uint8
+{
+	EBA_MELEE UMETA(DisplayName = "Melee attack"),
+	EBA_EVADE UMETA(DisplayName = "Evade"),
+	EBA_DOUBLESTEP UMETA(DisplayName = "Double step"),
+
+	EBA_MAX UMETA(DisplayName = "DefaultMAX")
+};
+
+// Full saber actors for heroes, lightweight blade components for background characters
+UENUM(BlueprintType)
+enum class ELightsaberMode : uint8
+{
+	ELM_ACTOR UMETA(DisplayName = "Actor"),
+	ELM_COMPONENT UMETA(DisplayName = "Component"),
+
+	ELM_MAX UMETA(DisplayName = "DefaultMAX")
+};
+
 UCLASS()
 class SWFL_API AMainCharacter : public ACharacter
 {
 	GENERATED_BODY()
 
+	// Performs the movement actions inside predicted moves
+	friend class USWFLCharacterMovementComponent;
+
 public:
 	// Sets default values for this character's properties
-	AMainCharacter();
+	AMainCharacter(const FObjectInitializer& ObjectInitializer);
 
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
+	// Sabers go away with their wielder
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	// Sabers are spawned by the server, clients attach them once they are replicated
+	UFUNCTION()
+	void OnRep_Lightsabers();
+
+	// Take a saber from the saber pool, or spawn it if there is no pool, and give it back when this character goes away
+	class ALightsaber* AcquireLightsaber(TSubclassOf<ALightsaber> LightsaberClass);
+	void ReleaseLightsaber(ALightsaber* Lightsaber, EEndPlayReason::Type EndPlayReason);
+
+	// Blade components are created by the server and replicated as subobjects of this character
+	class ULightsaberComponent* CreateLightsaberComponent(FName SocketName);
+	void DestroyLightsaberComponents();
+
+	// Sabers of whichever mode this character wields
+	bool AreLightsabersIgnited() const;
+	void SetLightsabersIgnited(bool bIgnited);
+	void SetTrailsVisible(bool bVisible);
+
+	UFUNCTION(Server, Reliable)
+	void ServerToggleLightsaber();
+
+	// Hits found by this client's left (0) or right (1) blade, validated by the server against rewound poses
+	UFUNCTION(Server, Reliable)
+	void ServerClaimBladeHit(uint8 Side, AMainCharacter* Victim, int32 ClaimedSwingId, FVector_NetQuantize10 BladeBase, FVector_NetQuantize10 BladeTip, float ViewTime);
+
 	// Called for forwards/backwards input
 	void MoveForward(float Value);
 
@@ -33,8 +89,6 @@ protected:
 	// @param Rate is a normalized rate, i.e. 1.0 means 100% of desired look up/down rate
 	void LookUpAtRate(float Rate);
 
-	// Jump
-	void DoubleJump();
 	virtual void Landed(const FHitResult& Hit) override;
 
 	// Evade
@@ -43,12 +97,17 @@ protected:
 	// DoubleStep
 	void DoubleStep();
 
-	// Switch the state of lightsaber
-	void ToggleLightsaber();
+	// Start an action inside the move that carries its request, replayed moves only redo the launch
+	void PerformDoubleJump(bool bReplaying);
+	void PerformEvade(bool bReplaying);
+	void PerformDoubleStep(bool bReplaying);
 
-	// Switch between run and jog
+	// Switch between walk and jog
 	void ToggleMovement();
 
+	// Walk or jog when not sprinting, set by the moves of the owning client
+	void SetWalking(bool bWalking);
+
 	// Sprint
 	void SprintOn();
 
@@ -57,8 +116,52 @@ protected:
 
 	void MeleeAttack();
 
+	// Input handlers, actions are buffered and performed as soon as the character is able to
+	void BufferMeleeAttack();
+	void BufferEvade();
+	void BufferDoubleStep();
+
+	// Perform the oldest buffered action if the character can, drop the ones which waited too long
+	void ConsumeBufferedInput();
+	bool CanPerformAction(EBufferedAction Action) const;
+
+	// Called by montage notifies, buffered actions may cancel the current attack while the window is open
+	UFUNCTION(BlueprintCallable)
+	void OpenCancelWindow();
+	UFUNCTION(BlueprintCallable)
+	void CloseCancelWindow();
+
+public:
+	// Actions below are bound to input and also driven by scripted and AI characters
+
+	// Jump
+	void DoubleJump();
+
+	// Switch the state of lightsaber
+	void ToggleLightsaber();
+
 	void ForcePush();
 
+	// Queue a melee attack, evade or double step as if its input had been pressed
+	void BufferAction(EBufferedAction Action);
+
+	// Send a hit of this character's left (0) or right (1) saber to the server, stamped with the server time this client sees
+	void ClaimBladeHit(int32 Side, AMainCharacter* Victim);
+
+	// Hit of this character's left (0) or right (1) blade found by its sweep. Queued for damage where it plays,
+	// and claimed from the server by the owning client of a player
+	void HandleBladeHit(int32 Side, AMainCharacter* Victim);
+
+	// Combat effects of a server frame this client can see, sent once per frame by the combat FX subsystem
+	UFUNCTION(Client, Unreliable)
+	void ClientPlayCombatFX(const TArray<FCombatFXEvent>& Events);
+
+	// Hit sound and effect of this character being hit at Location
+	void PlayHitFX(const FVector& Location);
+
+	// Effect of a force push of this character on the body at Location
+	void PlayForcePushFX(const FVector& Location);
+
 private:
 	// Camera boom positioning the camera behind the player
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Camera", meta = (AllowPrivateAccess = "true"))
@@ -88,7 +191,6 @@ private:
 	FVector JumpTwoHeigth{0.f, 0.f, 450.f};
 
 	bool bIsWalking;
-	bool bShouldJog;
 	bool bIsSprinting;
 
 	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = "Movement", meta = (AllowPrivateAccess = "true"))
@@ -97,10 +199,10 @@ private:
 	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = "Movement", meta = (AllowPrivateAccess = "true"))
 	bool bIsDoubleStepping;
 
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Weapon", meta = (AllowPrivateAccess = "true"))
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, ReplicatedUsing = OnRep_Lightsabers, Category = "Weapon", meta = (AllowPrivateAccess = "true"))
 	class ALightsaber* Lightsaber_l;
 
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Weapon", meta = (AllowPrivateAccess = "true"))
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, ReplicatedUsing = OnRep_Lightsabers, Category = "Weapon", meta = (AllowPrivateAccess = "true"))
 	ALightsaber* Lightsaber_r;
 
 	UPROPERTY(EditDefaultsOnly, Category = "Weapon")
@@ -109,6 +211,18 @@ private:
 	UPROPERTY(EditDefaultsOnly, Category = "Weapon")
 	TSubclassOf<ALightsaber> Lightsaber_2;
 
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Replicated, Category = "Weapon", meta = (AllowPrivateAccess = "true"))
+	ELightsaberMode LightsaberMode;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Weapon")
+	TSubclassOf<ULightsaberComponent> LightsaberComponentClass;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Replicated, Category = "Weapon", meta = (AllowPrivateAccess = "true"))
+	ULightsaberComponent* LightsaberComponent_l;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Replicated, Category = "Weapon", meta = (AllowPrivateAccess = "true"))
+	ULightsaberComponent* LightsaberComponent_r;
+
 	UPROPERTY(VisibleAnywhere, Category = "Components")
 	FName SocketSpawnRight;
 
@@ -145,9 +259,82 @@ private:
 	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = "Combat", meta = (AllowPrivateAccess = "true"))
 	int32 Combo = 0;
 
+	// Counts the swings started by MeleeAttack, sabers key their hits on it so a swing hits each victim once
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Combat", meta = (AllowPrivateAccess = "true"))
+	int32 SwingId = 0;
+
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Weapon | VFX", meta = (AllowPrivateAccess = "true"))
 	class UParticleSystem* ForceVFX;
 
+	// How long a buffered action waits for the character to be able to perform it, in seconds
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Combat", meta = (AllowPrivateAccess = "true"))
+	float InputBufferDuration = 0.35f;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Combat", meta = (AllowPrivateAccess = "true"))
+	bool bIsCancelWindowOpen = false;
+
+	struct FBufferedInput
+	{
+		EBufferedAction Action;
+		float Time;
+	};
+
+	// Ring buffer of pressed actions, oldest first from InputBufferHead
+	static constexpr int32 InputBufferSize = 8;
+	FBufferedInput InputBuffer[InputBufferSize];
+	int32 InputBufferHead = 0;
+	int32 InputBufferCount = 0;
+
+	// Force push reaches every simulated body within range and this half angle in degrees around the forward vector
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Combat", meta = (AllowPrivateAccess = "true"))
+	float ForcePushRange = 500.f;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Combat", meta = (AllowPrivateAccess = "true"))
+	float ForcePushAngle = 30.f;
+
+	// Velocity change given to pushed bodies
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Combat", meta = (AllowPrivateAccess = "true"))
+	float ForcePushStrength = 2000.f;
+
+	struct FForcePushTarget
+	{
+		UPrimitiveComponent* Component;
+		FVector Impulse;
+	};
+
+	// Bodies collected by the current push, kept to avoid reallocating
+	TArray<FForcePushTarget> ForcePushTargets;
+
+	// Shortest time between two swings, bounds how far a claimed swing id may be ahead of the last accepted one
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Combat", meta = (AllowPrivateAccess = "true"))
+	float MinSwingInterval = 0.2f;
+
+	// Hit claims accepted on one victim within ClaimWindow seconds, both sabers included
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Combat", meta = (AllowPrivateAccess = "true"))
+	int32 MaxClaimsPerVictim = 6;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Combat", meta = (AllowPrivateAccess = "true"))
+	float ClaimWindow = 1.f;
+
+	// Server side record of the claims of this character's client
+	int32 LastClaimedSwingId = INDEX_NONE;
+	float LastClaimedSwingTime = 0.f;
+
+	struct FVictimClaims
+	{
+		TWeakObjectPtr<AMainCharacter> Victim;
+		float WindowStart;
+		int32 NumClaims;
+	};
+
+	TArray<FVictimClaims> VictimClaims;
+
+	// Swing ids only move forward, one swing per MinSwingInterval at most, and each victim takes a bounded number of claims
+	bool AcceptClaimedSwing(int32 ClaimedSwingId, AMainCharacter* Victim);
+
+	// Damage is resolved at the end of the frame, once per victim for the whole swing
+	void QueueBladeHit(ILightsaberBlade* Blade, int32 HitSwingId, AMainCharacter* Victim);
+
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Combat", meta = (AllowPrivateAccess = "true"))
 	class USoundCue* HitSFX;
 
@@ -161,6 +348,9 @@ public:
 	// Called to bind functionality to input
 	virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
 
+	// World direction of the X (forward) or Y (right) movement axis for a control rotation, only its yaw counts
+	static FVector GetMovementDirection(const FRotator& ControlRotation, EAxis::Type Axis);
+
 	FORCEINLINE class USpringArmComponent* GetCameraBoom() const { return CameraBoom; }
 	FORCEINLINE class UCameraComponent* GetFollowCamera() const { return FollowCamera; }
 
@@ -170,15 +360,50 @@ public:
 	FORCEINLINE int32 GetCombo() const { return Combo; }
 	FORCEINLINE void SetCombo(int32 ComboCount) { Combo = ComboCount; }
 
+	FORCEINLINE int32 GetSwingId() const { return SwingId; }
+
 	FORCEINLINE class ALightsaber* GetLightsaberL() const { return Lightsaber_l; }
 	FORCEINLINE class ALightsaber* GetLightsaberR() const { return Lightsaber_r; }
 
+	// Classes of the sabers this character spawns with
+	FORCEINLINE TSubclassOf<ALightsaber> GetLightsaberClassL() const { return Lightsaber_1; }
+	FORCEINLINE TSubclassOf<ALightsaber> GetLightsaberClassR() const { return Lightsaber_2; }
+
+	FORCEINLINE class ULightsaberComponent* GetLightsaberComponentL() const { return LightsaberComponent_l; }
+	FORCEINLINE class ULightsaberComponent* GetLightsaberComponentR() const { return LightsaberComponent_r; }
+
+	FORCEINLINE ELightsaberMode GetLightsaberMode() const { return LightsaberMode; }
+
+	// Swap between saber actors and blade components, keeping the sabers ignited if they were. Server only
+	UFUNCTION(BlueprintCallable, Category = "Weapon")
+	void SetLightsaberMode(ELightsaberMode NewMode);
+
+	// Blade hit detection of both sabers, whichever mode they are in
+	UFUNCTION(BlueprintCallable, Category = "Weapon")
+	void SetBladeCollisionActive(bool bActive);
+
+	bool HasLightsabers() const;
+
+	// Blade of the left (0) or right (1) saber in whichever mode this character is, and the side of one of them
+	ILightsaberBlade* GetBlade(int32 Side) const;
+	int32 GetBladeSide(const ILightsaberBlade* Blade) const;
+
+	// Visible blade of the left (0) or right (1) saber
+	bool GetBladeSegment(int32 Side, FVector& OutBase, FVector& OutTip) const;
+	float GetBladeRadius(int32 Side) const;
+
 	FORCEINLINE USoundCue* GetHitSound() const { return HitSFX; }
 	FORCEINLINE UParticleSystem* GetHitVFX() const { return HitVFX; }
 
+	FORCEINLINE bool GetIsSprinting() const { return bIsSprinting; }
+	FORCEINLINE bool GetIsWalking() const { return bIsWalking; }
+
 	FORCEINLINE bool GetIsEvading() const { return bIsEvading; }
 	FORCEINLINE void SetIsEvading(bool Evades) { bIsEvading = Evades; }
 
 	FORCEINLINE bool GetIsDoubleStepping() const { return bIsDoubleStepping; }
 	FORCEINLINE void SetIsDoubleStepping(bool DoubleSteps) { bIsDoubleStepping = DoubleSteps; }
+
+	FORCEINLINE int32 GetDoubleJumpCounter() const { return DoubleJumpCounter; }
+	FORCEINLINE void SetDoubleJumpCounter(int32 Count) { DoubleJumpCounter = Count; }
 };
\ No newline at end of file
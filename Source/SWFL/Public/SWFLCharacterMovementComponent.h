@@ -0,0 +1,94 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "SWFLCharacterMovementComponent.generated.h"
+
+/**
+ * Character movement with double jump, evade and double step as predicted moves.
+ * The character only requests them, they start inside the next move on the owning client and, from the move's
+ * compressed flags, at the same point of the same move on the server. Corrections replay their physics only.
+ * Sprint input and the walk/jog toggle ride along with every move, so the server moves and plays evades at the client's rate.
+ */
+UCLASS()
+class SWFL_API USWFLCharacterMovementComponent : public UCharacterMovementComponent
+{
+	GENERATED_BODY()
+
+	friend class FSavedMove_SWFL;
+
+public:
+	USWFLCharacterMovementComponent();
+
+	// Performed at the start of the next move
+	void RequestDoubleJump();
+	void RequestEvade();
+	void RequestDoubleStep();
+
+	virtual void UpdateFromCompressedFlags(uint8 Flags) override;
+	virtual class FNetworkPredictionData_Client* GetPredictionData_Client() const override;
+
+protected:
+	virtual void UpdateCharacterStateBeforeMovement(float DeltaSeconds) override;
+
+private:
+	uint8 bWantsToDoubleJump : 1;
+	uint8 bWantsToEvade : 1;
+	uint8 bWantsToDoubleStep : 1;
+
+	// Follow the walk and sprint state of the move being performed
+	void SetWalking(bool bWalking);
+	void SetSprinting(bool bSprinting);
+};
+
+// Saved move carrying the requested abilities in the custom compressed flags
+class SWFL_API FSavedMove_SWFL : public FSavedMove_Character
+{
+public:
+	typedef FSavedMove_Character Super;
+
+	enum
+	{
+		FLAG_DoubleJump = FLAG_Custom_0,
+		FLAG_Evade = FLAG_Custom_1,
+		FLAG_DoubleStep = FLAG_Custom_2,
+		FLAG_Sprint = FLAG_Custom_3,
+
+		// Every custom flag is taken, the jog toggle uses the first reserved one
+		FLAG_Jog = FLAG_Reserved_1
+	};
+
+	FSavedMove_SWFL();
+
+	virtual void Clear() override;
+	virtual uint8 GetCompressedFlags() const override;
+	virtual bool CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const override;
+	virtual void SetMoveFor(ACharacter* Character, float InDeltaTime, FVector const& NewAccel, class FNetworkPredictionData_Client_Character& ClientData) override;
+	virtual void PrepMoveFor(ACharacter* Character) override;
+
+private:
+	uint8 bSavedWantsToDoubleJump : 1;
+	uint8 bSavedWantsToEvade : 1;
+	uint8 bSavedWantsToDoubleStep : 1;
+
+	// Sprint input held during the move, it sets the walk speed and the evade rate
+	uint8 bSavedSprinting : 1;
+
+	// Jogging rather than walking, the speed sprinting falls back to
+	uint8 bSavedJogging : 1;
+
+	// Jumps already made when the move started, replays count from it
+	uint8 SavedDoubleJumpCounter;
+};
+
+class SWFL_API FNetworkPredictionData_Client_SWFL : public FNetworkPredictionData_Client_Character
+{
+public:
+	typedef FNetworkPredictionData_Client_Character Super;
+
+	explicit FNetworkPredictionData_Client_SWFL(const UCharacterMovementComponent& ClientMovement);
+
+	virtual FSavedMovePtr AllocateNewMove() override;
+};
@@ -0,0 +1,29 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class AMainCharacter;
+
+/**
+ * Fixture shared by the headless test scenarios (crowd benchmark, bot soak test) to spawn and
+ * tear down AI driven characters in a -nullrhi game world.
+ */
+namespace SWFLHeadlessBots
+{
+	// Game worlds launched with the scenario's -Switch
+	SWFL_API bool IsRequested(const UObject* Outer, const TCHAR* Switch);
+
+	// The configured character class, the game mode's default pawn when unset, null and an error when neither is an AMainCharacter
+	SWFL_API UClass* ResolveCharacterClass(UWorld* World, const TSoftClassPtr<AMainCharacter>& CharacterClass, const TCHAR* LogPrefix);
+
+	// Location of the first player start
+	SWFL_API FVector GetSpawnOrigin(UWorld* World);
+
+	// Spawns a character possessed by its default controller
+	SWFL_API AMainCharacter* SpawnBot(UWorld* World, UClass* Class, const FVector& Location, const FRotator& Rotation);
+
+	// Destroys the character and its controller
+	SWFL_API void DestroyBot(AMainCharacter* Character);
+}
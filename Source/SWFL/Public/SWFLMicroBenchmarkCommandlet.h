@@ -0,0 +1,24 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "SWFLMicroBenchmarkCommandlet.generated.h"
+
+/**
+ * Times the saber and character hot routines in isolation and writes ns/op, p50/p99 and allocations per op as JSON.
+ * Blade traces run against a synthetic world of box colliders, nothing from the project's content is loaded.
+ *
+ * UE4Editor-Cmd SWFL.uproject -run=SWFLMicroBenchmark [-samples=2000] [-output=Path.json]
+ */
+UCLASS()
+class SWFL_API USWFLMicroBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	USWFLMicroBenchmarkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,81 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ReplicationGraph.h"
+#include "SWFLReplicationGraph.generated.h"
+
+// How actors of a class are routed to the graph nodes
+enum class ESWFLClassRepNodeMapping : uint8
+{
+	NotRouted,					// Replicated through the per-connection node only, player controllers
+	RelevantAllConnections,		// Always relevant, game state
+	FrequencyLimited,			// Relevant to everybody but seldom changing, spread over frames: player states and other infos
+	Spatialize_Dynamic,			// Moving actors in the grid, characters
+	Spatialize_Dormancy,		// Grid actors which move while awake only
+	Spatialize_Static,			// Grid actors which never move
+	Dependent,					// Replicated along with their owner, sabers
+};
+
+/**
+ * Replication graph for large arenas.
+ * Connections only gather the characters in the grid cells around their view, sabers are not considered on their own
+ * and replicate together with their wielder, and actors relevant to everybody but seldom changing share a budget of frames.
+ * Enabled by ReplicationDriverClassName in DefaultEngine.ini.
+ */
+UCLASS(Transient, Config = Engine)
+class SWFL_API USWFLReplicationGraph : public UReplicationGraph
+{
+	GENERATED_BODY()
+
+public:
+	virtual void InitGlobalActorClassSettings() override;
+	virtual void InitGlobalGraphNodes() override;
+	virtual void InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection) override;
+	virtual void RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo) override;
+	virtual void RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo) override;
+
+	// Replicate a dependent actor with NewOwner instead of OldOwner, either may be null, for sabers changing hands
+	void SetDependentOwner(AActor* Actor, AActor* OldOwner, AActor* NewOwner);
+
+private:
+	ESWFLClassRepNodeMapping GetMappingPolicy(UClass* Class) const;
+	void InitClassReplicationInfo(FClassReplicationInfo& Info, UClass* Class, bool bSpatialize) const;
+
+	// Size of a grid cell, connections gather the cells within the cull distance of their view
+	UPROPERTY(Config)
+	float SpatialCellSize = 2500.f;
+
+	// Lowest corner of the grid, actors below it are clamped to the first cells
+	UPROPERTY(Config)
+	float SpatialBiasX = -50000.f;
+
+	UPROPERTY(Config)
+	float SpatialBiasY = -50000.f;
+
+	// Characters farther than this from a connection's view are not replicated to it
+	UPROPERTY(Config)
+	float CharacterCullDistance = 15000.f;
+
+	UPROPERTY()
+	UReplicationGraphNode_GridSpatialization2D* GridNode;
+
+	UPROPERTY()
+	UReplicationGraphNode_ActorList* AlwaysRelevantNode;
+
+	UPROPERTY()
+	UReplicationGraphNode_ActorListFrequencyBuckets* FrequencyLimitedNode;
+
+	TClassMap<ESWFLClassRepNodeMapping> ClassRepNodePolicies;
+};
+
+// Viewer, view target and pawn of a connection, with the saber dependents of that pawn
+UCLASS()
+class SWFL_API USWFLReplicationGraphNode_AlwaysRelevant_ForConnection : public UReplicationGraphNode_AlwaysRelevant_ForConnection
+{
+	GENERATED_BODY()
+
+public:
+	virtual void GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params) override;
+};
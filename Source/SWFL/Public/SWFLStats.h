@@ -0,0 +1,88 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "Trace/Trace.h"
+
+// "stat SWFL" in game, or the SWFL group of a stats / Insights capture
+DECLARE_STATS_GROUP(TEXT("SWFL"), STATGROUP_SWFL, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Lightsaber Tick"), STAT_SWFL_LightsaberTick, STATGROUP_SWFL, SWFL_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Lightsaber RayCast"), STAT_SWFL_RayCast, STATGROUP_SWFL, SWFL_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Lightsaber SweepBlade"), STAT_SWFL_SweepBlade, STATGROUP_SWFL, SWFL_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Lightsaber DoDamage"), STAT_SWFL_DoDamage, STATGROUP_SWFL, SWFL_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Blade Simulation"), STAT_SWFL_Simulate, STATGROUP_SWFL, SWFL_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Clash Detection"), STAT_SWFL_Clash, STATGROUP_SWFL, SWFL_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Damage Resolve"), STAT_SWFL_ResolveHits, STATGROUP_SWFL, SWFL_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("MeleeAttack"), STAT_SWFL_MeleeAttack, STATGROUP_SWFL, SWFL_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("ForcePush"), STAT_SWFL_ForcePush, STATGROUP_SWFL, SWFL_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Combat FX Batch"), STAT_SWFL_CombatFXBatch, STATGROUP_SWFL, SWFL_API);
+
+// Reset every frame
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Blade traces"), STAT_SWFL_BladeTraces, STATGROUP_SWFL, SWFL_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("FX spawned"), STAT_SWFL_FXSpawned, STATGROUP_SWFL, SWFL_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Hits resolved"), STAT_SWFL_HitsResolved, STATGROUP_SWFL, SWFL_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Combat FX batches sent"), STAT_SWFL_CombatFXBatches, STATGROUP_SWFL, SWFL_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Combat FX events sent"), STAT_SWFL_CombatFXEvents, STATGROUP_SWFL, SWFL_API);
+
+// Kept up to date by their owners
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Sabers ticking"), STAT_SWFL_SabersTicking, STATGROUP_SWFL, SWFL_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Burn marks alive"), STAT_SWFL_BurnMarksAlive, STATGROUP_SWFL, SWFL_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Hum voices"), STAT_SWFL_HumVoices, STATGROUP_SWFL, SWFL_API);
+
+// Per-frame SWFL columns of CSV profiler captures
+CSV_DECLARE_CATEGORY_MODULE_EXTERN(SWFL_API, SWFL);
+
+// Counters recorded both as stats and in CSV captures, each a single statement
+#define SWFL_COUNT_BLADE_TRACES(Amount) \
+	do \
+	{ \
+		INC_DWORD_STAT_BY(STAT_SWFL_BladeTraces, Amount); \
+		CSV_CUSTOM_STAT(SWFL, BladeTraces, int32(Amount), ECsvCustomStatOp::Accumulate); \
+	} while (0)
+
+#define SWFL_COUNT_FX_SPAWNED() \
+	do \
+	{ \
+		INC_DWORD_STAT(STAT_SWFL_FXSpawned); \
+		CSV_CUSTOM_STAT(SWFL, FXSpawned, 1, ECsvCustomStatOp::Accumulate); \
+	} while (0)
+
+// Combat events recorded on the SWFLCombat trace channel, enable with -trace=cpu,SWFLCombat.
+// A single statement, safe under an unbraced if/else
+enum class ESWFLCombatEvent : uint8
+{
+	Ignite,
+	Extinguish,
+	Hit,
+	Push,
+	Clash
+};
+
+#if UE_TRACE_ENABLED
+
+UE_TRACE_CHANNEL_EXTERN(SWFLCombatChannel, SWFL_API);
+
+namespace SWFLTrace
+{
+	// Instigator and Target are recorded by unique id, Target may be null
+	SWFL_API void OutputCombatEvent(ESWFLCombatEvent Type, const UObject* Instigator, const UObject* Target, const FVector& Location);
+}
+
+#define TRACE_SWFL_COMBAT_EVENT(Type, Instigator, Target, Location) \
+	do \
+	{ \
+		if (UE_TRACE_CHANNELEXPR_IS_ENABLED(SWFLCombatChannel)) \
+		{ \
+			SWFLTrace::OutputCombatEvent(ESWFLCombatEvent::Type, Instigator, Target, Location); \
+		} \
+	} while (0)
+
+#else
+
+#define TRACE_SWFL_COMBAT_EVENT(Type, Instigator, Target, Location) do { } while (0)
+
+#endif